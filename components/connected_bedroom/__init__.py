@@ -1,9 +1,11 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
+from esphome.core import ID, TimePeriod
 from esphome.components import uart, sensor, binary_sensor, switch, alarm_control_panel, button, light, number
+from esphome.components.connected_bedroom_bus import ConnectedBedroomBus, ConnectedBedroomBusNode, CONF_CONNECTED_BEDROOM_BUS_ID
 from esphome.components.light.types import LightEffect
 from esphome.components.light.effects import register_rgb_effect
-from esphome.const import CONF_ID, CONF_SWITCHES, CONF_ENTITY_ID, CONF_OUTPUT_ID, CONF_DEFAULT_TRANSITION_LENGTH, CONF_GAMMA_CORRECT, CONF_NAME
+from esphome.const import CONF_ID, CONF_ADDRESS, CONF_NUM_LEDS, CONF_SPEED, CONF_INTENSITY, CONF_SWITCHES, CONF_ENTITY_ID, CONF_OUTPUT_ID, CONF_DEFAULT_TRANSITION_LENGTH, CONF_GAMMA_CORRECT, CONF_NAME, CONF_INTERVAL, DEVICE_CLASS_CONNECTIVITY, STATE_CLASS_MEASUREMENT, ENTITY_CATEGORY_DIAGNOSTIC, UNIT_MILLISECOND
 
 CODEOWNERS = ["@zetiti10"]
 
@@ -11,6 +13,15 @@ MULTI_CONF = True
 DEPENDENCIES = ['uart']
 AUTO_LOAD = ['sensor', 'binary_sensor', 'switch', 'alarm_control_panel', 'button', 'light', 'number']
 
+# Longueur maximale d'une trame reçue par l'Arduino Mega (`protocol::MEGA_LINE_MAX_LENGTH`) et de l'en-tête `7KKNN`
+# d'un morceau : un morceau ne peut pas porter plus de données que leur différence.
+MEGA_LINE_MAX_LENGTH = 60
+CHUNK_HEADER_LENGTH = 5
+MAX_CHUNK_SIZE = MEGA_LINE_MAX_LENGTH - CHUNK_HEADER_LENGTH
+
+# Durée maximale d'une transition d'un ruban de DEL RVB (`protocol::MAX_TRANSITION_LENGTH`, champ de 5 chiffres).
+MAX_TRANSITION_LENGTH = TimePeriod(milliseconds=99999)
+
 connected_bedroom_ns = cg.esphome_ns.namespace('connected_bedroom')
 
 ConnectedBedroom = connected_bedroom_ns.class_('ConnectedBedroom', cg.Component, uart.UARTDevice)
@@ -25,8 +36,10 @@ TelevisionState = connected_bedroom_ns.class_('TelevisionState', switch.Switch,
 TelevisionMuted = connected_bedroom_ns.class_('TelevisionMuted', switch.Switch, TelevisionComponent)
 TelevisionVolumeUp = connected_bedroom_ns.class_('TelevisionVolumeUp', button.Button, TelevisionComponent)
 TelevisionVolumeDown = connected_bedroom_ns.class_('TelevisionVolumeDown', button.Button, TelevisionComponent)
+TelevisionVolume = connected_bedroom_ns.class_('TelevisionVolume', number.Number, TelevisionComponent)
 ConnectedBedroomTelevision = connected_bedroom_ns.class_('ConnectedBedroomTelevision', cg.Component, ConnectedBedroomDevice)
 ConnectedBedroomRGBLEDStrip = connected_bedroom_ns.class_('ConnectedBedroomRGBLEDStrip', cg.Component, ConnectedBedroom)
+ConnectedBedroomAddressableLEDStrip = connected_bedroom_ns.class_('ConnectedBedroomAddressableLEDStrip', light.AddressableLight, ConnectedBedroomDevice)
 ConnectedBedroomRGBLEDStripRainbowEffect = connected_bedroom_ns.class_('ConnectedBedroomRGBLEDStripRainbowEffect', LightEffect)
 ConnectedBedroomRGBLEDStripSoundreactEffect = connected_bedroom_ns.class_('ConnectedBedroomRGBLEDStripSoundreactEffect', LightEffect)
 ConnectedBedroomRGBLEDStripAlarmEffect = connected_bedroom_ns.class_('ConnectedBedroomRGBLEDStripAlarmEffect', LightEffect)
@@ -40,13 +53,17 @@ ENUM_CONNECTED_LIGHT_TYPES = {
 }
 
 CONF_ANALOG_SENSORS = "analog_sensors"
+CONF_SLOT = "slot"
+CONF_SCALE = "scale"
 CONF_BINARY_SENSORS = "binary_sensors"
+CONF_PUBLISH_EVERY_TRANSITION = "publish_every_transition"
 CONF_ALARMS = "alarms"
 CONF_MISSILE_LAUNCHER = "missile_launcher"
 CONF_BASE_NUMBER = "base_number"
 CONF_ANGLE_NUMBER = "angle_number"
 CONF_LAUNCH_BUTTON = "launch_button"
 CONF_MISSILES_SENSOR = "missiles_sensor"
+CONF_AIM_COALESCING_WINDOW = "aim_coalescing_window"
 CONF_CODES = "codes"
 CONF_TELEVISIONS = "televisions"
 CONF_STATE_SWITCH = "state_switch"
@@ -54,10 +71,53 @@ CONF_MUTE_SWITCH = "mute_switch"
 CONF_VOLUME_UP_BUTTON = "volume_up_button"
 CONF_VOLUME_DOWN_BUTTON = "volume_down_button"
 CONF_VOLUME_STATE = "volume_state"
+CONF_VOLUME_NUMBER = "volume_number"
 CONF_RGB_LED_STRIPS = "RGB_LED_strips"
+CONF_ADDRESSABLE_LED_STRIPS = "addressable_LED_strips"
 CONF_CONNECTED_LIGHTS = "connected_lights"
 CONF_CONNECTED_LIGHT_TYPE = "type"
 CONF_COMMUNICATION_ID = "communication_id"
+CONF_RESTORE_STATES = "restore_states"
+CONF_STATE_SAVE_INTERVAL = "state_save_interval"
+CONF_RELIABLE_COMMANDS = "reliable_commands"
+CONF_RETRANSMIT_TIMEOUT = "retransmit_timeout"
+CONF_MAX_RETRANSMITS = "max_retransmits"
+CONF_HEARTBEAT = "heartbeat"
+CONF_MAX_MISSED = "max_missed"
+CONF_RTT = "rtt"
+CONF_JITTER = "jitter"
+CONF_LINK = "link"
+CONF_COMMAND_TRACING = "command_tracing"
+CONF_LOOP_PROFILER = "loop_profiler"
+CONF_SOAK_TEST_SERVICES = "soak_test_services"
+CONF_TRAFFIC_RECORDER = "traffic_recorder"
+CONF_SIZE = "size"
+CONF_NODE_ID = "node_id"
+CONF_MUSIC_PRESETS = "music_presets"
+CONF_SPEECH_MIN_INTERVAL = "speech_min_interval"
+CONF_SPEECH_CHARACTERS_PER_SECOND = "speech_characters_per_second"
+CONF_BATCH_FRAMES = "batch_frames"
+CONF_CHUNKED_TRANSMIT = "chunked_transmit"
+CONF_CHUNK_SIZE = "chunk_size"
+CONF_INITIAL_CREDIT = "initial_credit"
+CONF_CREDIT_TIMEOUT = "credit_timeout"
+CONF_DISPLAY = "display"
+CONF_COLUMNS = "columns"
+CONF_ROWS = "rows"
+CONF_MAX_PAGES = "max_pages"
+CONF_PALETTE = "palette"
+CONF_SOUND_GAIN = "sound_gain"
+
+
+async def effect_parameters_to_code(var, config):
+    if CONF_SPEED in config:
+        cg.add(var.set_speed(config[CONF_SPEED]))
+    if CONF_INTENSITY in config:
+        cg.add(var.set_intensity(config[CONF_INTENSITY]))
+    if CONF_PALETTE in config:
+        cg.add(var.set_palette(config[CONF_PALETTE]))
+    if CONF_SOUND_GAIN in config:
+        cg.add(var.set_sound_gain(config[CONF_SOUND_GAIN]))
 
 
 @register_rgb_effect(
@@ -65,10 +125,14 @@ CONF_COMMUNICATION_ID = "communication_id"
     ConnectedBedroomRGBLEDStripRainbowEffect,
     "Arc-en-ciel",
     {
+        cv.Optional(CONF_SPEED, default=128): cv.uint8_t,
+        cv.Optional(CONF_INTENSITY, default=255): cv.uint8_t,
+        cv.Optional(CONF_PALETTE, default=0): cv.uint8_t,
     },
 )
 async def rainbow_effect_to_code(config, effect_id):
     var = cg.new_Pvariable(effect_id, config[CONF_NAME])
+    await effect_parameters_to_code(var, config)
     return var
 
 
@@ -77,10 +141,14 @@ async def rainbow_effect_to_code(config, effect_id):
     ConnectedBedroomRGBLEDStripSoundreactEffect,
     "Son-réaction",
     {
+        cv.Optional(CONF_INTENSITY, default=255): cv.uint8_t,
+        cv.Optional(CONF_PALETTE, default=0): cv.uint8_t,
+        cv.Optional(CONF_SOUND_GAIN, default=128): cv.uint8_t,
     },
 )
 async def soundreact_effect_to_code(config, effect_id):
     var = cg.new_Pvariable(effect_id, config[CONF_NAME])
+    await effect_parameters_to_code(var, config)
     return var
 
 
@@ -89,19 +157,101 @@ async def soundreact_effect_to_code(config, effect_id):
     ConnectedBedroomRGBLEDStripAlarmEffect,
     "Alarme",
     {
+        cv.Optional(CONF_SPEED, default=128): cv.uint8_t,
+        cv.Optional(CONF_INTENSITY, default=255): cv.uint8_t,
     },
 )
 async def alarm_effect_to_code(config, effect_id):
     var = cg.new_Pvariable(effect_id, config[CONF_NAME])
+    await effect_parameters_to_code(var, config)
     return var
 
-CONFIG_SCHEMA = uart.UART_DEVICE_SCHEMA.extend(
+def validate_display_frame_length(config):
+    # Un message mis en forme (`6titre/ligne|ligne/ligne...`) qui peut dépasser le tampon de réception de l'Arduino
+    # Mega doit être envoyé par morceaux.
+    if CONF_DISPLAY in config and CONF_CHUNKED_TRANSMIT not in config:
+        display = config[CONF_DISPLAY]
+        columns = display[CONF_COLUMNS]
+        lines = display[CONF_ROWS] * display[CONF_MAX_PAGES]
+        max_length = 1 + columns + lines * (1 + columns)
+        if max_length > MEGA_LINE_MAX_LENGTH:
+            raise cv.Invalid(
+                f"Display messages can reach {max_length} bytes, more than the {MEGA_LINE_MAX_LENGTH} bytes the "
+                f"Arduino can receive in one frame: '{CONF_CHUNKED_TRANSMIT}' is required (or a smaller display "
+                f"geometry)",
+                path=[CONF_DISPLAY],
+            )
+    return config
+
+CONFIG_SCHEMA = cv.All(uart.UART_DEVICE_SCHEMA.extend(
     {
         cv.GenerateID(): cv.declare_id(ConnectedBedroom),
+        # Arduino relié par un bus partagé (`connected_bedroom_bus`) plutôt que par une liaison UART dédiée.
+        cv.Optional(CONF_CONNECTED_BEDROOM_BUS_ID): cv.use_id(ConnectedBedroomBus),
+        cv.Optional(CONF_ADDRESS): cv.int_range(min=0, max=99),
+        cv.GenerateID(CONF_NODE_ID): cv.declare_id(ConnectedBedroomBusNode),
+        cv.Optional(CONF_RESTORE_STATES, default=True): cv.boolean,
+        cv.Optional(CONF_STATE_SAVE_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_RELIABLE_COMMANDS, default=False): cv.boolean,
+        cv.Optional(CONF_RETRANSMIT_TIMEOUT, default="200ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MAX_RETRANSMITS, default=3): cv.int_range(min=0, max=20),
+        cv.Optional(CONF_AIM_COALESCING_WINDOW, default="100ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_SPEECH_MIN_INTERVAL, default="1s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_SPEECH_CHARACTERS_PER_SECOND, default=14): cv.int_range(min=0, max=100),
+        cv.Optional(CONF_BATCH_FRAMES, default=False): cv.boolean,
+        cv.Optional(CONF_CHUNKED_TRANSMIT): cv.Schema(
+            {
+                cv.Optional(CONF_CHUNK_SIZE, default=32): cv.int_range(min=8, max=MAX_CHUNK_SIZE),
+                cv.Optional(CONF_INITIAL_CREDIT, default=2): cv.int_range(min=1, max=99),
+                cv.Optional(CONF_CREDIT_TIMEOUT, default="500ms"): cv.positive_time_period_milliseconds,
+            }
+        ),
+        cv.Optional(CONF_DISPLAY): cv.Schema(
+            {
+                cv.Optional(CONF_COLUMNS, default=20): cv.int_range(min=4, max=80),
+                cv.Optional(CONF_ROWS, default=3): cv.int_range(min=1, max=8),
+                cv.Optional(CONF_MAX_PAGES, default=3): cv.int_range(min=1, max=10),
+            }
+        ),
+        cv.Optional(CONF_MUSIC_PRESETS): cv.All(cv.ensure_list(cv.string_strict), cv.Length(min=1, max=1000)),
+        cv.Optional(CONF_COMMAND_TRACING, default=False): cv.boolean,
+        cv.Optional(CONF_LOOP_PROFILER, default=False): cv.boolean,
+        cv.Optional(CONF_SOAK_TEST_SERVICES, default=False): cv.boolean,
+        cv.Optional(CONF_TRAFFIC_RECORDER): cv.Schema(
+            {
+                cv.Optional(CONF_SIZE, default=64): cv.int_range(min=1, max=4096),
+            }
+        ),
+        cv.Optional(CONF_HEARTBEAT): cv.Schema(
+            {
+                cv.Optional(CONF_INTERVAL, default="5s"): cv.positive_time_period_milliseconds,
+                cv.Optional(CONF_MAX_MISSED, default=3): cv.int_range(min=1, max=255),
+                cv.Optional(CONF_RTT): sensor.sensor_schema(
+                    unit_of_measurement=UNIT_MILLISECOND,
+                    accuracy_decimals=0,
+                    state_class=STATE_CLASS_MEASUREMENT,
+                    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                ),
+                cv.Optional(CONF_JITTER): sensor.sensor_schema(
+                    unit_of_measurement=UNIT_MILLISECOND,
+                    accuracy_decimals=1,
+                    state_class=STATE_CLASS_MEASUREMENT,
+                    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                ),
+                # État de la liaison : source de disponibilité des interrupteurs, alarmes, lumières et télévisions,
+                # dont l'état ne peut pas être rendu inconnu lorsque la liaison est perdue.
+                cv.Optional(CONF_LINK): binary_sensor.binary_sensor_schema(
+                    device_class=DEVICE_CLASS_CONNECTIVITY,
+                    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                ),
+            }
+        ),
         cv.Optional(CONF_ANALOG_SENSORS): cv.ensure_list(
             sensor.SENSOR_SCHEMA.extend(
                 {
                     cv.Required(CONF_COMMUNICATION_ID): cv.positive_int,
+                    cv.Optional(CONF_SLOT): cv.int_range(min=0, max=7),
+                    cv.Optional(CONF_SCALE, default=1.0): cv.float_,
                 }
             )
         ),
@@ -110,6 +260,7 @@ CONFIG_SCHEMA = uart.UART_DEVICE_SCHEMA.extend(
             binary_sensor.BINARY_SENSOR_SCHEMA.extend(
                 {
                     cv.Required(CONF_COMMUNICATION_ID): cv.positive_int,
+                    cv.Optional(CONF_PUBLISH_EVERY_TRANSITION, default=False): cv.boolean,
                 }
             )
         ),
@@ -169,6 +320,10 @@ CONFIG_SCHEMA = uart.UART_DEVICE_SCHEMA.extend(
                         cv.GenerateID(): cv.declare_id(TelevisionVolumeDown),
                     }),
                 cv.Required(CONF_VOLUME_STATE) : sensor.SENSOR_SCHEMA,
+                cv.Optional(CONF_VOLUME_NUMBER) : number.NUMBER_SCHEMA.extend(
+                    {
+                        cv.GenerateID(): cv.declare_id(TelevisionVolume),
+                    }),
             }
         ),
 
@@ -177,10 +332,23 @@ CONFIG_SCHEMA = uart.UART_DEVICE_SCHEMA.extend(
                 {
                     cv.GenerateID(CONF_OUTPUT_ID) : cv.declare_id(ConnectedBedroomRGBLEDStrip),
                     cv.Required(CONF_COMMUNICATION_ID): cv.positive_int,
+                    cv.Optional(CONF_DEFAULT_TRANSITION_LENGTH, default="0s"): cv.All(
+                        cv.positive_time_period_milliseconds, cv.Range(max=MAX_TRANSITION_LENGTH)
+                    ),
                 }
             )
         ),
 
+        cv.Optional(CONF_ADDRESSABLE_LED_STRIPS): cv.ensure_list(
+            light.ADDRESSABLE_LIGHT_SCHEMA.extend(
+                {
+                    cv.GenerateID(CONF_OUTPUT_ID) : cv.declare_id(ConnectedBedroomAddressableLEDStrip),
+                    cv.Required(CONF_COMMUNICATION_ID): cv.positive_int,
+                    cv.Required(CONF_NUM_LEDS): cv.int_range(min=1, max=999),
+                }
+            ).extend(cv.COMPONENT_SCHEMA)
+        ),
+
         cv.Optional(CONF_CONNECTED_LIGHTS): cv.ensure_list(
             {
                 cv.Required(CONF_COMMUNICATION_ID): cv.positive_int,
@@ -191,25 +359,97 @@ CONFIG_SCHEMA = uart.UART_DEVICE_SCHEMA.extend(
             }
         ),
     }
-)
+), cv.has_none_or_all_keys(CONF_CONNECTED_BEDROOM_BUS_ID, CONF_ADDRESS), validate_display_frame_length)
 
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
-    await uart.register_uart_device(var, config)
+    if CONF_CONNECTED_BEDROOM_BUS_ID in config:
+        bus = await cg.get_variable(config[CONF_CONNECTED_BEDROOM_BUS_ID])
+        node = cg.new_Pvariable(config[CONF_NODE_ID])
+        cg.add(node.set_address(config[CONF_ADDRESS]))
+        cg.add(bus.add_node(node))
+        cg.add(var.set_uart_parent(node))
+        # Chaque microcontrôleur du bus a ses propres services (`print_message_on_display_NN`...).
+        cg.add(var.set_service_suffix(f"_{config[CONF_ADDRESS]:02d}"))
+    else:
+        await uart.register_uart_device(var, config)
+    cg.add(var.set_restore_states(config[CONF_RESTORE_STATES]))
+    cg.add(var.set_state_save_interval(config[CONF_STATE_SAVE_INTERVAL]))
+    cg.add(var.set_preference_key(str(config[CONF_ID])))
+    cg.add(var.set_reliable_commands(config[CONF_RELIABLE_COMMANDS]))
+    cg.add(var.set_retransmit_timeout(config[CONF_RETRANSMIT_TIMEOUT]))
+    cg.add(var.set_max_retransmits(config[CONF_MAX_RETRANSMITS]))
+    cg.add(var.set_aim_coalescing_window(config[CONF_AIM_COALESCING_WINDOW]))
+
+    cg.add(var.set_speech_min_interval(config[CONF_SPEECH_MIN_INTERVAL]))
+    cg.add(var.set_speech_characters_per_second(config[CONF_SPEECH_CHARACTERS_PER_SECOND]))
+    cg.add(var.set_batch_frames(config[CONF_BATCH_FRAMES]))
+
+    if CONF_CHUNKED_TRANSMIT in config:
+        chunked_transmit = config[CONF_CHUNKED_TRANSMIT]
+        cg.add(
+            var.set_chunked_transmit(
+                chunked_transmit[CONF_CHUNK_SIZE],
+                chunked_transmit[CONF_INITIAL_CREDIT],
+                chunked_transmit[CONF_CREDIT_TIMEOUT],
+            )
+        )
+
+    if CONF_DISPLAY in config:
+        display = config[CONF_DISPLAY]
+        cg.add(var.set_display_geometry(display[CONF_COLUMNS], display[CONF_ROWS], display[CONF_MAX_PAGES]))
+
+    if CONF_MUSIC_PRESETS in config:
+        # Les URL sont placées à la suite, terminées par un caractère nul, dans un tableau en mémoire flash.
+        presets = config[CONF_MUSIC_PRESETS]
+        data = [byte for url in presets for byte in url.encode("utf-8") + b"\0"]
+        presets_id = ID(f"{config[CONF_ID].id}_music_presets", is_declaration=True, type=cg.uint8)
+        presets_array = cg.progmem_array(presets_id, data)
+        cg.add(var.set_music_presets(presets_array, len(presets)))
+
+    if config[CONF_COMMAND_TRACING]:
+        cg.add_define("USE_CONNECTED_BEDROOM_TRACING")
+
+    if config[CONF_LOOP_PROFILER]:
+        cg.add_define("USE_CONNECTED_BEDROOM_PROFILER")
+
+    if config[CONF_SOAK_TEST_SERVICES]:
+        cg.add_define("USE_CONNECTED_BEDROOM_SOAK_TEST")
+
+    if CONF_TRAFFIC_RECORDER in config:
+        cg.add_define("USE_CONNECTED_BEDROOM_RECORDER")
+        cg.add(var.set_traffic_recorder_size(config[CONF_TRAFFIC_RECORDER][CONF_SIZE]))
+
+    if CONF_HEARTBEAT in config:
+        heartbeat = config[CONF_HEARTBEAT]
+        cg.add(var.set_heartbeat_interval(heartbeat[CONF_INTERVAL]))
+        cg.add(var.set_max_missed_heartbeats(heartbeat[CONF_MAX_MISSED]))
+        if CONF_RTT in heartbeat:
+            rtt_sensor = await sensor.new_sensor(heartbeat[CONF_RTT])
+            cg.add(var.set_rtt_sensor(rtt_sensor))
+        if CONF_JITTER in heartbeat:
+            jitter_sensor = await sensor.new_sensor(heartbeat[CONF_JITTER])
+            cg.add(var.set_jitter_sensor(jitter_sensor))
+        if CONF_LINK in heartbeat:
+            link_sensor = await binary_sensor.new_binary_sensor(heartbeat[CONF_LINK])
+            cg.add(var.set_link_sensor(link_sensor))
 
     if CONF_ANALOG_SENSORS in config:
         for conf in config[CONF_ANALOG_SENSORS]:
             analog_sensor = await sensor.new_sensor(conf)
             communication_id = conf[CONF_COMMUNICATION_ID]
-            cg.add(var.add_analog_sensor(communication_id, analog_sensor))
+            if CONF_SLOT in conf:
+                cg.add(var.add_analog_sensor_slot(communication_id, conf[CONF_SLOT], conf[CONF_SCALE], analog_sensor))
+            else:
+                cg.add(var.add_analog_sensor(communication_id, analog_sensor))
 
     if CONF_BINARY_SENSORS in config:
         for conf in config[CONF_BINARY_SENSORS]:
             binary_sensor_ = await binary_sensor.new_binary_sensor(conf)
             communication_id = conf[CONF_COMMUNICATION_ID]
-            cg.add(var.add_binary_sensor(communication_id, binary_sensor_))
+            cg.add(var.add_binary_sensor(communication_id, binary_sensor_, conf[CONF_PUBLISH_EVERY_TRANSITION]))
 
     if CONF_SWITCHES in config:
         for conf in config[CONF_SWITCHES]:
@@ -256,12 +496,14 @@ async def to_code(config):
             cg.add(volume_up_button.set_parent(television_var))
             volume_down_button = await button.new_button(conf[CONF_VOLUME_DOWN_BUTTON])
             cg.add(volume_down_button.set_parent(television_var))
+            if CONF_VOLUME_NUMBER in conf:
+                volume_number = await number.new_number(conf[CONF_VOLUME_NUMBER], min_value=0, max_value=99, step=1)
+                cg.add(volume_number.set_parent(television_var))
             volume = await sensor.new_sensor(conf[CONF_VOLUME_STATE])
             cg.add(television_var.setVolumeSensor(volume))
 
     if CONF_RGB_LED_STRIPS in config:
         for conf in config[CONF_RGB_LED_STRIPS]:
-            conf[CONF_DEFAULT_TRANSITION_LENGTH] = 0
             conf[CONF_GAMMA_CORRECT] = 0
             strip_var = cg.new_Pvariable(conf[CONF_OUTPUT_ID])
             await light.register_light(strip_var, conf)
@@ -269,6 +511,15 @@ async def to_code(config):
             cg.add(strip_var.set_communication_id(communication_id))
             cg.add(strip_var.set_parent(var))
 
+    if CONF_ADDRESSABLE_LED_STRIPS in config:
+        for conf in config[CONF_ADDRESSABLE_LED_STRIPS]:
+            strip_var = cg.new_Pvariable(conf[CONF_OUTPUT_ID])
+            await cg.register_component(strip_var, conf)
+            await light.register_light(strip_var, conf)
+            cg.add(strip_var.set_num_leds(conf[CONF_NUM_LEDS]))
+            cg.add(strip_var.set_communication_id(conf[CONF_COMMUNICATION_ID]))
+            cg.add(strip_var.set_parent(var))
+
     if CONF_CONNECTED_LIGHTS in config:
         for conf in config[CONF_CONNECTED_LIGHTS]:
             cg.add(var.add_connected_device(conf[CONF_COMMUNICATION_ID], conf[CONF_ENTITY_ID], conf[CONF_CONNECTED_LIGHT_TYPE]))
@@ -7,10 +7,15 @@
  */
 
 // Ajout des bibilothèques au programme.
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
 
 // Autres fichiers du programme.
 #include "connected_bedroom.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 
 namespace esphome {
@@ -18,36 +23,239 @@ namespace connected_bedroom {
 
 static const char *TAG = "connected_bedroom";
 
-/// @brief Fonction permettant de convertir un entier en une chaîne de caractère à longueur fixe, complétée de `0` si
-/// nécessaire.
-/// @param number L'entier à convertir.
-/// @param length La longueur de la chaîne de caractères voulue.
-/// @return La chaîne de caractère formatée.
-std::string addZeros(int number, int length) {
-  std::string result = std::to_string(number);
-  while (result.length() < static_cast<size_t>(length))
-    result = "0" + result;
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+// Bornes supérieures (en microsecondes) des classes des histogrammes de latence.
+static const uint32_t LATENCY_BUCKET_BOUNDS[LATENCY_BUCKETS_COUNT - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000};
+
+// Noms des types de périphériques tracés, pour l'affichage des histogrammes.
+static const char *const TRACED_DEVICE_TYPE_NAMES[TRACED_DEVICE_TYPES_COUNT] = {
+    "switch", "alarm", "missile_launcher", "television", "RGB_LED_strip"};
+
+/// @brief Fonction permettant d'obtenir la classe d'un histogramme de latence correspondant à une durée.
+/// @param duration La durée en microsecondes.
+/// @return L'indice de la classe.
+static uint8_t getLatencyBucket(uint32_t duration) {
+  uint8_t bucket = 0;
+  while (bucket < LATENCY_BUCKETS_COUNT - 1 && duration > LATENCY_BUCKET_BOUNDS[bucket])
+    bucket++;
+
+  return bucket;
+}
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_PROFILER
+// Noms des phases mesurées par le profileur.
+static const char *const LOOP_PHASE_NAMES[LOOP_PHASES_COUNT] = {
+    "loop", "RX drain", "decode", "lookup", "publish_state", "LightCall::perform", "HA service"};
+
+#define CONNECTED_BEDROOM_PROFILE_CONCAT_(a, b) a##b
+#define CONNECTED_BEDROOM_PROFILE_NAME_(line) CONNECTED_BEDROOM_PROFILE_CONCAT_(loop_profiler_scope_, line)
+#define CONNECTED_BEDROOM_PROFILE(phase) \
+  LoopProfilerScope CONNECTED_BEDROOM_PROFILE_NAME_(__LINE__)(&this->loop_profiler_, phase)
+#else
+#define CONNECTED_BEDROOM_PROFILE(phase)
+#endif
+
+// Délais de la synchronisation automatique après le rétablissement de la liaison.
+static const uint32_t MIN_RESYNC_BACKOFF = 1000;
+static const uint32_t MAX_RESYNC_BACKOFF = 60000;
+
+/// @brief Fonction permettant d'obtenir l'équivalent ASCII d'un caractère Unicode pour l'écran de l'Arduino Mega.
+/// @param code_point Le caractère Unicode (hors ASCII).
+/// @return Les caractères ASCII à afficher à la place.
+static const char *getDisplayEquivalent(uint32_t code_point) {
+  switch (code_point) {
+    case 0xE0:  // à
+    case 0xE2:  // â
+    case 0xE4:  // ä
+      return "a";
+    case 0xC0:
+    case 0xC2:
+    case 0xC4:
+      return "A";
+    case 0xE7:  // ç
+      return "c";
+    case 0xC7:
+      return "C";
+    case 0xE8:  // è
+    case 0xE9:  // é
+    case 0xEA:  // ê
+    case 0xEB:  // ë
+      return "e";
+    case 0xC8:
+    case 0xC9:
+    case 0xCA:
+    case 0xCB:
+      return "E";
+    case 0xEE:  // î
+    case 0xEF:  // ï
+      return "i";
+    case 0xCE:
+    case 0xCF:
+      return "I";
+    case 0xF4:  // ô
+    case 0xF6:  // ö
+      return "o";
+    case 0xD4:
+    case 0xD6:
+      return "O";
+    case 0xF9:  // ù
+    case 0xFB:  // û
+    case 0xFC:  // ü
+      return "u";
+    case 0xD9:
+    case 0xDB:
+    case 0xDC:
+      return "U";
+    case 0xFF:  // ÿ
+      return "y";
+    case 0x178:
+      return "Y";
+    case 0x153:  // œ
+      return "oe";
+    case 0x152:
+      return "OE";
+    case 0xE6:  // æ
+      return "ae";
+    case 0xC6:
+      return "AE";
+    case 0xA0:    // Espace insécable.
+    case 0x202F:  // Espace fine insécable.
+      return " ";
+    case 0x2018:
+    case 0x2019:  // Apostrophe typographique.
+      return "'";
+    case 0xAB:  // «
+    case 0xBB:  // »
+    case 0x201C:
+    case 0x201D:
+      return "\"";
+    case 0x2013:
+    case 0x2014:
+      return "-";
+    case 0x2026:  // Points de suspension.
+      return "...";
+    case 0x20AC:
+      return "EUR";
+    default:
+      return "?";
+  }
+}
+
+/// @brief Fonction permettant de convertir un texte UTF-8 en caractères affichables par l'écran de l'Arduino Mega.
+/// Les caractères réservés au protocole (`/` et `|`) sont remplacés par des points.
+/// @param text Le texte UTF-8.
+/// @return Le texte en ASCII.
+static std::string transliterateForDisplay(const std::string &text) {
+  std::string result;
+  result.reserve(text.size());
+
+  for (size_t i = 0; i < text.size();) {
+    uint8_t byte = text[i];
+    uint32_t code_point;
+    size_t length;
+    if (byte < 0x80) {
+      code_point = byte;
+      length = 1;
+    } else if ((byte & 0xE0) == 0xC0) {
+      code_point = byte & 0x1F;
+      length = 2;
+    } else if ((byte & 0xF0) == 0xE0) {
+      code_point = byte & 0x0F;
+      length = 3;
+    } else if ((byte & 0xF8) == 0xF0) {
+      code_point = byte & 0x07;
+      length = 4;
+    } else {
+      result.push_back('?');
+      i++;
+      continue;
+    }
+
+    if (i + length > text.size())
+      break;
+    for (size_t j = 1; j < length; j++)
+      code_point = (code_point << 6) | (uint8_t(text[i + j]) & 0x3F);
+    i += length;
+
+    if (code_point == '/' || code_point == '|')
+      result.push_back('.');
+    else if (code_point == '\t')
+      result.push_back(' ');
+    else if (code_point == '\n' || (code_point >= 0x20 && code_point < 0x7F))
+      result.push_back(char(code_point));
+    else if (code_point >= 0x80)
+      result += getDisplayEquivalent(code_point);
+  }
 
   return result;
 }
 
-/// @brief Fonction permettant de récupérer un entier à partir d'une chaîne de caractères.
-/// @param string La chaîne de caractère contenant l'entier à extraire.
-/// @param position La position du premier chiffre de l'entier.
-/// @param lenght La longueur de l'entier dans la chaîne de caractères.
-/// @return L'entier extrait.
-int getIntFromVector(std::vector<uint8_t> &string, int position, int lenght) {
-  int result = 0;
+/// @brief Fonction permettant de découper un texte en lignes de l'écran de l'Arduino Mega, en coupant entre les mots
+/// (les mots plus longs qu'une ligne sont coupés). Si le texte ne tient pas, la dernière ligne se termine par `...`.
+/// @param text Le texte en ASCII (`\n` force un retour à la ligne).
+/// @param columns Le nombre de caractères par ligne.
+/// @param max_lines Le nombre maximal de lignes.
+/// @return Les lignes à afficher.
+static std::vector<std::string> wrapForDisplay(const std::string &text, uint8_t columns, size_t max_lines) {
+  std::vector<std::string> lines;
+  std::string line;
+  bool truncated = false;
+
+  auto push_line = [&]() {
+    if (lines.size() >= max_lines)
+      truncated = true;
+    else
+      lines.push_back(line);
+    line.clear();
+  };
+
+  size_t position = 0;
+  while (position <= text.size() && !truncated) {
+    size_t end = text.find_first_of(" \n", position);
+    if (end == std::string::npos)
+      end = text.size();
+    std::string word = text.substr(position, end - position);
+
+    while (word.size() > columns) {
+      if (!line.empty())
+        push_line();
+      line = word.substr(0, columns);
+      word.erase(0, columns);
+      push_line();
+    }
+
+    if (!word.empty()) {
+      if (line.empty()) {
+        line = word;
+      } else if (line.size() + 1 + word.size() <= columns) {
+        line += ' ';
+        line += word;
+      } else {
+        push_line();
+        line = word;
+      }
+    }
+
+    if (end < text.size() && text[end] == '\n')
+      push_line();
+    position = end + 1;
+  }
 
-  for (int i = 0; i < lenght; i++) {
-    int power = 1;
-    for (int j = 0; j < ((lenght - i) - 1); j++)
-      power *= 10;
+  if (!line.empty())
+    push_line();
+  while (!lines.empty() && lines.back().empty())
+    lines.pop_back();
 
-    result += (string[position + i] - '0') * power;
+  if (truncated && !lines.empty()) {
+    std::string &last = lines.back();
+    if (last.size() + 3 > columns)
+      last.resize(columns > 3 ? columns - 3 : 0);
+    last += "...";
   }
 
-  return result;
+  return lines;
 }
 
 /// @brief Méthode permettant d'obtenir la priorité d'initialisation du composant externe.
@@ -56,9 +264,52 @@ float ConnectedBedroom::get_setup_priority() const { return setup_priority::DATA
 
 /// @brief Méthode d'initialisation du composant externe.
 void ConnectedBedroom::setup() {
+  // Publication des derniers états connus, en attendant la synchronisation avec l'Arduino Mega.
+  this->persisted_states_.epoch = UNKNOWN_EPOCH;
+  if (this->restore_states_) {
+    this->states_preference_ =
+        global_preferences->make_preference<PersistedStates>(fnv1_hash(this->preference_key_), true);
+    this->publish_persisted_states_();
+  }
+
   // Déclaration du service permettant d'afficher à l'écran du système un message.
   this->register_service(&esphome::connected_bedroom::ConnectedBedroom::send_message_to_Arduino_,
-                         "print_message_on_display", {"title", "message"});
+                         "print_message_on_display" + this->service_suffix_, {"title", "message"});
+
+#ifdef USE_CONNECTED_BEDROOM_SOAK_TEST
+  // Déclaration des services de test d'endurance (compteurs du trafic et injection de trames de l'Arduino Mega).
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::dump_link_statistics_,
+                         "dump_link_statistics" + this->service_suffix_);
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::reset_link_statistics_,
+                         "reset_link_statistics" + this->service_suffix_);
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::inject_frame_,
+                         "inject_frame" + this->service_suffix_, {"frame"});
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_RECORDER
+  // Allocation de l'enregistreur du trafic UART et déclaration des services permettant de le consulter.
+  this->traffic_records_.resize(this->traffic_recorder_size_);
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::dump_traffic_,
+                         "dump_traffic" + this->service_suffix_);
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::clear_traffic_,
+                         "clear_traffic" + this->service_suffix_);
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_PROFILER
+  // Déclaration des services permettant de consulter et réinitialiser les mesures du profileur.
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::dump_loop_profile_,
+                         "dump_loop_profile" + this->service_suffix_);
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::reset_loop_profile_,
+                         "reset_loop_profile" + this->service_suffix_);
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+  // Déclaration des services permettant de consulter et réinitialiser les histogrammes de latence des commandes.
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::dump_command_latency_,
+                         "dump_command_latency" + this->service_suffix_);
+  this->register_service(&esphome::connected_bedroom::ConnectedBedroom::reset_command_latency_,
+                         "reset_command_latency" + this->service_suffix_);
+#endif
 
   // Enregistrement des périphériques distants (pour reçevoir les mises à jour d'état des périphériques connectés).
   for (auto connected_light : this->connected_lights_) {
@@ -97,536 +348,832 @@ void ConnectedBedroom::setup() {
 
 /// @brief Méthode d'exécution des tâches liées à la connexion.
 void ConnectedBedroom::loop() {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOP);
+
   // Au démarrage du système, on envoie un signal à l'Arduino Mega (on ne le fait pas dans le setup() car la communication en UART n'est pas encore initialisée).
   if (!synchronized_) {
-    this->write('3');
-    this->write('0');
-    this->write('0');
-    this->write('\n');
+    this->request_synchronization_();
 
     synchronized_ = true;
   }
 
   // Lecture des messages venant de l'Arduino Mega.
-  while (this->available()) {
-    uint8_t letter = this->read();
+  {
+    CONNECTED_BEDROOM_PROFILE(PHASE_RX_DRAIN);
 
-    if (letter == '\r')
-      continue;
+    // Les mises à jour reçues pendant la lecture ne sont publiées qu'à la fin de celle-ci.
+    this->staging_updates_ = true;
 
-    if (letter == '\n')
-      this->process_message_();
+    while (this->available()) {
+      uint8_t letter = this->read();
 
-    else
-      this->receivedMessage_.push_back(letter);
+#ifdef USE_CONNECTED_BEDROOM_RECORDER
+      this->record_traffic_(TRAFFIC_RX, &letter, 1);
+#endif
+
+      if (letter == '\r')
+        continue;
+
+      if (letter == '\n') {
+#ifdef USE_CONNECTED_BEDROOM_SOAK_TEST
+        this->link_statistics_.rx_frames++;
+#endif
+        this->mark_link_alive_();
+        this->process_message_();
+      }
+
+      else
+        this->receivedMessage_.push_back(letter);
+    }
+
+    this->staging_updates_ = false;
   }
+
+  if (this->staged_updates_count_ > 0)
+    this->publish_staged_updates_();
+
+  // Surveillance de la liaison avec l'Arduino Mega.
+  if (this->heartbeat_interval_ > 0)
+    this->process_heartbeat_();
+
+  // Envoi des visées des lance-missiles regroupées.
+  if (!this->pending_aims_.empty())
+    this->process_aims_();
+
+  // Émission du message suivant par l'enceinte.
+  if (!this->speech_queue_.empty())
+    this->process_speech_queue_();
+
+  // Envoi des mises à jour des périphériques connectés reçues de Home Assistant depuis l'itération précédente.
+  if (!this->pending_connected_updates_.empty())
+    this->send_connected_updates_();
+
+  // Envoi du morceau suivant des longues trames.
+  if (!this->bulk_frames_.empty())
+    this->process_bulk_frames_();
+
+  // Renvoi des trames critiques non acquittées.
+  if (this->reliable_commands_)
+    this->process_retransmissions_();
+
+  // Enregistrement des derniers états connus (limité pour préserver la mémoire flash).
+  if (this->states_dirty_ && millis() - this->last_states_save_ >= this->state_save_interval_)
+    this->save_states_();
 }
 
+/// @brief Table de décodage des trames reçues de l'Arduino Mega, parcourue dans l'ordre : les trames avec sous-code
+/// doivent précéder les trames de même code sans sous-code.
+const FrameRoute ConnectedBedroom::FRAME_ROUTES[] = {
+    // Ordres destinés aux périphériques connectés de Home Assistant.
+    {&protocol::OrderConnectedDevicePower::matches, &ConnectedBedroom::handle_connected_device_power_},
+    {&protocol::OrderTemperatureLightTemperature::matches,
+     &ConnectedBedroom::handle_connected_light_temperature_<protocol::OrderTemperatureLightTemperature>},
+    {&protocol::OrderTemperatureLightBrightness::matches,
+     &ConnectedBedroom::handle_connected_light_brightness_<protocol::OrderTemperatureLightBrightness>},
+    {&protocol::OrderColorLightColor::matches, &ConnectedBedroom::handle_connected_light_color_},
+    {&protocol::OrderColorLightTemperature::matches,
+     &ConnectedBedroom::handle_connected_light_temperature_<protocol::OrderColorLightTemperature>},
+    {&protocol::OrderColorLightBrightness::matches,
+     &ConnectedBedroom::handle_connected_light_brightness_<protocol::OrderColorLightBrightness>},
+
+    // Mises à jour de l'état des périphériques de l'Arduino Mega.
+    {&protocol::UpdatePower::matches, &ConnectedBedroom::handle_power_update_},
+    {&protocol::UpdateRGBLEDStripColor::matches, &ConnectedBedroom::handle_RGB_LED_strip_color_update_},
+    {&protocol::UpdateRGBLEDStripEffect::matches, &ConnectedBedroom::handle_RGB_LED_strip_effect_update_},
+    {&protocol::UpdateAlarmArmed::matches, &ConnectedBedroom::handle_alarm_armed_update_},
+    {&protocol::UpdateAlarmTriggered::matches, &ConnectedBedroom::handle_alarm_triggered_update_},
+    {&protocol::UpdateMissileLauncherBase::matches, &ConnectedBedroom::handle_missile_launcher_base_update_},
+    {&protocol::UpdateMissileLauncherAngle::matches, &ConnectedBedroom::handle_missile_launcher_angle_update_},
+    {&protocol::UpdateMissileLauncherMissiles::matches, &ConnectedBedroom::handle_missile_launcher_missiles_update_},
+    {&protocol::UpdateMissileLauncherAim::matches, &ConnectedBedroom::handle_missile_launcher_aim_update_},
+    {&protocol::UpdateTelevisionVolume::matches, &ConnectedBedroom::handle_television_volume_update_},
+    {&protocol::UpdateTelevisionMuted::matches, &ConnectedBedroom::handle_television_muted_update_},
+    {&protocol::UpdateTelevisionUnmuted::matches, &ConnectedBedroom::handle_television_unmuted_update_},
+    {&protocol::UpdateBinarySensor::matches, &ConnectedBedroom::handle_binary_sensor_update_},
+    {&protocol::UpdateAnalogSensor::matches, &ConnectedBedroom::handle_analog_sensor_update_},
+    {&protocol::UpdateTemperatureSensor::matches, &ConnectedBedroom::handle_temperature_sensor_update_},
+    {&protocol::UpdateMultiValueSensor::matches, &ConnectedBedroom::handle_multi_value_sensor_update_},
+
+    // Messages, synchronisation, alimentation et musique.
+    {&protocol::TextMessage::matches, &ConnectedBedroom::handle_speech_message_},
+    {&protocol::ControlSynchronization::matches, &ConnectedBedroom::handle_synchronization_request_},
+    {&protocol::ControlShutdown::matches, &ConnectedBedroom::handle_shutdown_request_},
+    {&protocol::ControlEpoch::matches, &ConnectedBedroom::handle_epoch_},
+    {&protocol::ControlAcknowledgement::matches, &ConnectedBedroom::handle_acknowledgement_},
+    {&protocol::ControlPing::matches, &ConnectedBedroom::handle_pong_},
+    {&protocol::ControlChunkCredit::matches, &ConnectedBedroom::handle_chunk_credit_},
+    {&protocol::MusicURL::matches, &ConnectedBedroom::handle_music_},
+    {&protocol::MusicPreset::matches, &ConnectedBedroom::handle_music_preset_},
+};
+
 /// @brief Méthode de traitement des messages reçus de l'Arduino Mega.
 void ConnectedBedroom::process_message_() {
+  if (this->receivedMessage_.empty())
+    return;
+
+  CONNECTED_BEDROOM_PROFILE(PHASE_DECODE);
+
   String message;
   for (int i = 0; i < this->receivedMessage_.size(); i++)
     message += char(this->receivedMessage_[i]);
   ESP_LOGD(TAG, "Message received from Arduino: '%s'.", message.c_str());
 
-  // Requête d'un ordre.
-  switch (getIntFromVector(this->receivedMessage_, 0, 1)) {
-    case 0: {
-      int communication_id = getIntFromVector(this->receivedMessage_, 1, 2);
+  if (protocol::Batch::matches(this->receivedMessage_))
+    this->process_batch_();
+  else
+    this->dispatch_frame_();
+
+  this->receivedMessage_.clear();
+}
 
-      switch (getIntFromVector(this->receivedMessage_, 3, 2)) {
-        // Contrôle de l'alimentation.
-        case 0: {
-          std::string connected_light_entity_id = this->get_connected_device_from_communication_id_(communication_id);
+/// @brief Traite, en une seule lecture, une trame regroupant plusieurs trames (`8NN` puis `LL` et la trame de chaque
+/// enregistrement). Chaque enregistrement est traité comme une trame reçue seule.
+void ConnectedBedroom::process_batch_() {
+  std::vector<uint8_t> batch;
+  batch.swap(this->receivedMessage_);
 
-          if (connected_light_entity_id == "")
-            break;
+  int count = protocol::Batch::get<0>(batch);
+  size_t position = protocol::Batch::length();
+  for (int i = 0; i < count; i++) {
+    int length = protocol::read_digits(batch, position, protocol::BatchRecordLength::length());
+    position += protocol::BatchRecordLength::length();
 
-          switch (getIntFromVector(this->receivedMessage_, 5, 1)) {
-            case 0: {
-              this->call_homeassistant_service("light.turn_off", {{"entity_id", connected_light_entity_id}});
-              break;
-            }
+    if (length <= 0 || position + length > batch.size()) {
+      ESP_LOGW(TAG, "Truncated batch frame, %d of %d records processed.", i, count);
+      break;
+    }
 
-            case 1: {
-              this->call_homeassistant_service("light.turn_on", {{"entity_id", connected_light_entity_id}});
-              break;
-            }
+    // Les trames regroupées ne peuvent pas elles-mêmes en regrouper d'autres.
+    if (batch[position] != protocol::FRAME_BATCH) {
+      this->receivedMessage_.assign(batch.begin() + position, batch.begin() + position + length);
+      this->dispatch_frame_();
+    }
 
-            case 2: {
-              this->call_homeassistant_service("light.toggle", {{"entity_id", connected_light_entity_id}});
-              break;
-            }
-          }
+    position += length;
+  }
 
-          break;
-        }
-
-        // Contrôle le l'ampoule distante à température de couleur variable.
-        case 4: {
-          std::string connected_light_entity_id = this->get_connected_device_from_communication_id_(communication_id);
-
-          if (connected_light_entity_id == "")
-            break;
-
-          switch (getIntFromVector(this->receivedMessage_, 5, 1)) {
-            case 0: {
-              this->call_homeassistant_service("light.turn_on",
-                                               {{"entity_id", connected_light_entity_id},
-                                                {"kelvin", to_string(getIntFromVector(this->receivedMessage_, 6, 4))}});
-              break;
-            }
-
-            case 1: {
-              this->call_homeassistant_service(
-                  "light.turn_on", {{"entity_id", connected_light_entity_id},
-                                    {"brightness", to_string(getIntFromVector(this->receivedMessage_, 6, 3))}});
-              break;
-            }
-          }
+  // Le tampon de réception retrouve sa capacité, pour ne pas être réalloué à la trame suivante.
+  this->receivedMessage_.swap(batch);
+}
 
-          break;
-        }
-
-        // Contrôle le l'ampoule distante à couleur variable.
-        case 5: {
-          std::string connected_light_entity_id = this->get_connected_device_from_communication_id_(communication_id);
-
-          if (connected_light_entity_id == "")
-            break;
-
-          switch (getIntFromVector(this->receivedMessage_, 5, 1)) {
-            case 0: {
-              this->call_homeassistant_service("script.esphome_changer_de_couleur",
-                                               {{"light", connected_light_entity_id},
-                                                {"r", to_string(getIntFromVector(this->receivedMessage_, 6, 3))},
-                                                {"g", to_string(getIntFromVector(this->receivedMessage_, 9, 3))},
-                                                {"b", to_string(getIntFromVector(this->receivedMessage_, 12, 3))}});
-              break;
-            }
-
-            case 1: {
-              this->call_homeassistant_service("light.turn_on",
-                                               {{"entity_id", connected_light_entity_id},
-                                                {"kelvin", to_string(getIntFromVector(this->receivedMessage_, 6, 4))}});
-              break;
-            }
-
-            case 2: {
-              this->call_homeassistant_service(
-                  "light.turn_on", {{"entity_id", connected_light_entity_id},
-                                    {"brightness", to_string(getIntFromVector(this->receivedMessage_, 6, 3))}});
-              break;
-            }
-          }
+/// @brief Traite une trame (isolée ou extraite d'une trame regroupée) en la confiant à la méthode correspondant à son
+/// type dans `FRAME_ROUTES`.
+void ConnectedBedroom::dispatch_frame_() {
+  bool update = this->receivedMessage_[0] == protocol::FRAME_UPDATE;
+
+  // Extraction de la version de l'état du périphérique, éventuellement ajoutée à la fin d'une mise à jour ("#VVV").
+  int version = -1;
+  if (update) {
+    auto separator =
+        std::find(this->receivedMessage_.begin(), this->receivedMessage_.end(), protocol::VERSION_SEPARATOR);
+    if (separator != this->receivedMessage_.end()) {
+      int position = separator - this->receivedMessage_.begin();
+      if (this->receivedMessage_.size() - position == 1 + protocol::VERSION_WIDTH)
+        version = protocol::read_digits(this->receivedMessage_, position + 1, protocol::VERSION_WIDTH);
+      this->receivedMessage_.erase(separator, this->receivedMessage_.end());
+    }
+  }
 
-          break;
-        }
-      }
+  // Les ordres et les mises à jour concernent un périphérique.
+  int communication_id = -1;
+  if (update || this->receivedMessage_[0] == protocol::FRAME_ORDER)
+    communication_id = protocol::read_digits(this->receivedMessage_, 1, protocol::COMMUNICATION_ID_WIDTH);
 
+  const FrameRoute *route = nullptr;
+  for (const FrameRoute &candidate : FRAME_ROUTES) {
+    if (candidate.matches(this->receivedMessage_)) {
+      route = &candidate;
       break;
     }
+  }
 
-    // Requête d'une mise-à-jour.
-    case 1: {
-      int communication_id = getIntFromVector(this->receivedMessage_, 1, 2);
-
-      switch (getIntFromVector(this->receivedMessage_, 3, 2)) {
-        // Mise à jour de l'état de l'alimentation.
-        case 1: {
-          switch_::Switch *switch_ = this->get_switch_from_communication_id_(communication_id);
-          if (switch_ != nullptr) {
-            switch_->publish_state(getIntFromVector(this->receivedMessage_, 5, 1));
+  if (route != nullptr)
+    (this->*route->handle)(communication_id);
+  else
+    ESP_LOGV(TAG, "Unknown or truncated frame ignored.");
 
-            break;
-          }
+  if (update && communication_id >= 0) {
+    if (version >= 0)
+      this->remember_version_(communication_id, version);
 
-          alarm_control_panel::AlarmControlPanel *alarm = this->get_alarm_from_communication_id_(communication_id);
-          if (alarm != nullptr) {
-            if (getIntFromVector(this->receivedMessage_, 5, 1) == 0)
-              alarm->publish_state(alarm_control_panel::ACP_STATE_DISARMED);
+    this->trace_command_confirmed_(communication_id);
+  }
+}
 
-            else if (getIntFromVector(this->receivedMessage_, 5, 1) == 1)
-              alarm->publish_state(alarm_control_panel::ACP_STATE_ARMED_AWAY);
+/// @brief Contrôle de l'alimentation d'un périphérique connecté de Home Assistant.
+/// @param communication_id L'identifiant de communication du périphérique.
+void ConnectedBedroom::handle_connected_device_power_(int communication_id) {
+  std::string connected_light_entity_id = this->get_connected_device_from_communication_id_(communication_id);
+  if (connected_light_entity_id == "")
+    return;
 
-            break;
-          }
+  const char *services[] = {"light.turn_off", "light.turn_on", "light.toggle"};
+  int state = protocol::OrderConnectedDevicePower::get<0>(this->receivedMessage_);
+  if (state < 0 || state > 2)
+    return;
 
-          ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
-          if (television != nullptr) {
-            television->state->publish_state(getIntFromVector(this->receivedMessage_, 5, 1));
+  CONNECTED_BEDROOM_PROFILE(PHASE_HA_SERVICE);
+  this->call_homeassistant_service(services[state], {{"entity_id", connected_light_entity_id}});
+}
 
-            break;
-          }
+/// @brief Contrôle de la température de couleur d'une ampoule distante.
+/// @tparam Frame Le type de la trame (les ampoules à température de couleur et à couleur variables ont leur code).
+/// @param communication_id L'identifiant de communication de l'ampoule.
+template<typename Frame> void ConnectedBedroom::handle_connected_light_temperature_(int communication_id) {
+  std::string connected_light_entity_id = this->get_connected_device_from_communication_id_(communication_id);
+  if (connected_light_entity_id == "")
+    return;
 
-          ConnectedBedroomRGBLEDStrip *strip = this->get_RGB_LED_strip_from_communication_id(communication_id);
-          if (strip != nullptr) {
-            auto call = strip->state->make_call();
-            call.set_state(getIntFromVector(this->receivedMessage_, 5, 1));
-            strip->block_next_write();
-            call.perform();
-          }
+  CONNECTED_BEDROOM_PROFILE(PHASE_HA_SERVICE);
+  this->call_homeassistant_service(
+      "light.turn_on", {{"entity_id", connected_light_entity_id},
+                        {"kelvin", to_string(Frame::template get<0>(this->receivedMessage_))}});
+}
 
-          break;
-        }
-
-        // Mise à jour de l'état du ruban de DEL RVB.
-        case 2: {
-          ConnectedBedroomRGBLEDStrip *strip = this->get_RGB_LED_strip_from_communication_id(communication_id);
-
-          if (strip == nullptr)
-            break;
-
-          switch (getIntFromVector(this->receivedMessage_, 5, 1)) {
-            case 0: {
-              int r_int = getIntFromVector(this->receivedMessage_, 6, 3);
-              int g_int = getIntFromVector(this->receivedMessage_, 9, 3);
-              int b_int = getIntFromVector(this->receivedMessage_, 12, 3);
-
-              float r_float = float(r_int) / 255.0f;
-              float g_float = float(g_int) / 255.0f;
-              float b_float = float(b_int) / 255.0f;
-
-              auto call = strip->state->make_call();
-              call.set_rgb(r_float, g_float, b_float);
-              call.set_effect(0u);
-              call.set_state(true);
-              strip->block_next_write();
-              call.perform();
-
-              break;
-            }
-
-            case 1: {
-              auto call = strip->state->make_call();
-              call.set_effect("Arc-en-ciel");
-              call.set_state(true);
-              call.perform();
-              break;
-            }
-
-            case 2: {
-              auto call = strip->state->make_call();
-              call.set_effect("Son-réaction");
-              call.set_state(true);
-              call.perform();
-              break;
-            }
-
-            case 3: {
-              auto call = strip->state->make_call();
-              call.set_effect("Alarme");
-              call.set_state(true);
-              call.perform();
-              break;
-            }
-          }
+/// @brief Contrôle de la luminosité d'une ampoule distante.
+/// @tparam Frame Le type de la trame (les ampoules à température de couleur et à couleur variables ont leur code).
+/// @param communication_id L'identifiant de communication de l'ampoule.
+template<typename Frame> void ConnectedBedroom::handle_connected_light_brightness_(int communication_id) {
+  std::string connected_light_entity_id = this->get_connected_device_from_communication_id_(communication_id);
+  if (connected_light_entity_id == "")
+    return;
 
-          break;
-        }
-
-        // Mise à jour de l'état de l'alarme.
-        case 3: {
-          switch (getIntFromVector(this->receivedMessage_, 5, 1)) {
-            case 0: {
-              alarm_control_panel::AlarmControlPanel *alarm = this->get_alarm_from_communication_id_(communication_id);
-              if (alarm == nullptr)
-                break;
-              alarm->publish_state(alarm_control_panel::ACP_STATE_ARMED_AWAY);
-              break;
-            }
-
-            case 1: {
-              alarm_control_panel::AlarmControlPanel *alarm = this->get_alarm_from_communication_id_(communication_id);
-              if (alarm == nullptr)
-                break;
-              alarm->publish_state(alarm_control_panel::ACP_STATE_TRIGGERED);
-              break;
-            }
-
-            case 2: {
-              number::Number *button = this->get_missile_launcher_base_number_from_communication_id_(communication_id);
-              if (button == nullptr)
-                break;
-              button->publish_state(float(getIntFromVector(receivedMessage_, 6, 3)));
-              break;
-            }
-
-            case 3: {
-              number::Number *button = this->get_missile_launcher_angle_number_from_communication_id_(communication_id);
-              if (button == nullptr)
-                break;
-              button->publish_state(float(getIntFromVector(receivedMessage_, 6, 3)));
-              break;
-            }
-
-            case 4: {
-              sensor::Sensor *sensor =
-                  this->get_missile_launcher_available_missiles_sensor_from_communication_id_(communication_id);
-              if (sensor == nullptr)
-                break;
-              int count = getIntFromVector(receivedMessage_, 6, 1) + getIntFromVector(receivedMessage_, 7, 1) +
-                          getIntFromVector(receivedMessage_, 8, 1);
-              sensor->publish_state(float(count));
-              break;
-            }
-          }
+  CONNECTED_BEDROOM_PROFILE(PHASE_HA_SERVICE);
+  this->call_homeassistant_service(
+      "light.turn_on", {{"entity_id", connected_light_entity_id},
+                        {"brightness", to_string(Frame::template get<0>(this->receivedMessage_))}});
+}
 
-          break;
-        }
+/// @brief Contrôle de la couleur d'une ampoule distante à couleur variable.
+/// @param communication_id L'identifiant de communication de l'ampoule.
+void ConnectedBedroom::handle_connected_light_color_(int communication_id) {
+  std::string connected_light_entity_id = this->get_connected_device_from_communication_id_(communication_id);
+  if (connected_light_entity_id == "")
+    return;
 
-        // Mise à jour de l'état de la télévision.
-        case 4: {
-          ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
+  using Frame = protocol::OrderColorLightColor;
+  CONNECTED_BEDROOM_PROFILE(PHASE_HA_SERVICE);
+  this->call_homeassistant_service("script.esphome_changer_de_couleur",
+                                   {{"light", connected_light_entity_id},
+                                    {"r", to_string(Frame::get<0>(this->receivedMessage_))},
+                                    {"g", to_string(Frame::get<1>(this->receivedMessage_))},
+                                    {"b", to_string(Frame::get<2>(this->receivedMessage_))}});
+}
 
-          if (television == nullptr)
-            break;
+/// @brief Mise à jour de l'état de l'alimentation d'un périphérique.
+/// @param communication_id L'identifiant de communication du périphérique.
+void ConnectedBedroom::handle_power_update_(int communication_id) {
+  int state = protocol::UpdatePower::get<0>(this->receivedMessage_);
 
-          switch (getIntFromVector(this->receivedMessage_, 5, 1)) {
-            case 0: {
-              television->volume->publish_state(getIntFromVector(this->receivedMessage_, 6, 2));
-              break;
-            }
+  switch_::Switch *switch_ = this->get_switch_from_communication_id_(communication_id);
+  if (switch_ != nullptr) {
+    this->stage_update_(communication_id, STAGED_SLOT_STATE, STAGED_SWITCH, switch_, state);
+    this->remember_state_(communication_id, PERSISTED_SWITCH_STATE, state);
+    return;
+  }
 
-            case 1: {
-              television->muted->publish_state(true);
-              break;
-            }
+  alarm_control_panel::AlarmControlPanel *alarm = this->get_alarm_from_communication_id_(communication_id);
+  if (alarm != nullptr) {
+    alarm_control_panel::AlarmControlPanelState alarm_state;
+    if (state == 0)
+      alarm_state = alarm_control_panel::ACP_STATE_DISARMED;
 
-            case 2: {
-              television->muted->publish_state(false);
-              break;
-            }
-          }
+    else if (state == 1)
+      alarm_state = alarm_control_panel::ACP_STATE_ARMED_AWAY;
 
-          break;
-        }
-
-        // Mise à jour de l'état du capteur binaire.
-        case 7: {
-          binary_sensor::BinarySensor *binary_sensor = this->get_binary_sensor_from_communication_id_(communication_id);
-          if (binary_sensor == nullptr)
-            break;
-          binary_sensor->publish_state(getIntFromVector(this->receivedMessage_, 5, 1));
-          break;
-        }
-
-        // Mise à jour de l'état du capteur analogique.
-        case 8: {
-          sensor::Sensor *analog_sensor = this->get_analog_sensor_from_communication_id_(communication_id);
-          if (analog_sensor == nullptr)
-            break;
-          analog_sensor->publish_state(getIntFromVector(this->receivedMessage_, 5, 4));
-          break;
-        }
+    else
+      return;
 
-        // Mise à jour de l'état du capteur de température.
-        case 9: {
-          sensor::Sensor *analog_sensor = this->get_analog_sensor_from_communication_id_(communication_id);
-          if (analog_sensor == nullptr)
-            break;
-          analog_sensor->publish_state(float(getIntFromVector(this->receivedMessage_, 5, 4)) / float(100));
+    this->stage_update_(communication_id, STAGED_SLOT_STATE, STAGED_ALARM, alarm, alarm_state);
+    this->remember_state_(communication_id, PERSISTED_ALARM_STATE, alarm_state);
+    return;
+  }
 
-          analog_sensor = this->get_analog_sensor_from_communication_id_(communication_id + 1);
-          if (analog_sensor == nullptr)
-            break;
-          analog_sensor->publish_state(float(getIntFromVector(this->receivedMessage_, 9, 4)) / float(100));
+  ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
+  if (television != nullptr) {
+    this->stage_update_(communication_id, STAGED_SLOT_STATE, STAGED_SWITCH, television->state, state);
+    this->remember_state_(communication_id, PERSISTED_TELEVISION_STATE, state);
+    return;
+  }
 
-          break;
-        }
-      }
-      break;
+  ConnectedBedroomRGBLEDStrip *strip = this->get_RGB_LED_strip_from_communication_id(communication_id);
+  if (strip != nullptr) {
+    auto call = strip->state->make_call();
+    call.set_transition_length(0);
+    call.set_state(state);
+    {
+      CONNECTED_BEDROOM_PROFILE(PHASE_LIGHT_CALL);
+      call.perform();
     }
+    strip->confirm_power(state);
+    this->remember_state_(communication_id, PERSISTED_RGB_LED_STRIP_STATE, state);
+  }
+}
 
-    // Requête de l'émission d'un message.
-    case 2: {
-      std::string message;
-      for (int i = 1; i < this->receivedMessage_.size(); i++)
-        message.push_back(this->receivedMessage_[i]);
+/// @brief Mise à jour de la couleur d'un ruban de DEL RVB.
+/// @param communication_id L'identifiant de communication du ruban.
+void ConnectedBedroom::handle_RGB_LED_strip_color_update_(int communication_id) {
+  ConnectedBedroomRGBLEDStrip *strip = this->get_RGB_LED_strip_from_communication_id(communication_id);
+  if (strip == nullptr)
+    return;
 
-      this->call_homeassistant_service(
-          "script.emettre_un_message",
-          {{"volume", "1.0"}, {"message", message}, {"enceinte", "media_player.reveil_google_cast_de_la_chambre_de_louis"}});
+  using Frame = protocol::UpdateRGBLEDStripColor;
+  int r_int = Frame::get<0>(this->receivedMessage_);
+  int g_int = Frame::get<1>(this->receivedMessage_);
+  int b_int = Frame::get<2>(this->receivedMessage_);
+
+  float r_float = float(r_int) / 255.0f;
+  float g_float = float(g_int) / 255.0f;
+  float b_float = float(b_int) / 255.0f;
+
+  auto call = strip->state->make_call();
+  call.set_transition_length(0);
+  call.set_rgb(r_float, g_float, b_float);
+  call.set_effect(0u);
+  call.set_state(true);
+  {
+    CONNECTED_BEDROOM_PROFILE(PHASE_LIGHT_CALL);
+    call.perform();
+  }
+  strip->confirm_color();
+  this->remember_state_(communication_id, PERSISTED_RGB_LED_STRIP_STATE, 1);
+  this->remember_state_(communication_id, PERSISTED_RGB_LED_STRIP_COLOR, r_int, g_int, b_int);
+}
 
-      break;
-    }
+/// @brief Mise à jour du mode d'un ruban de DEL RVB.
+/// @param communication_id L'identifiant de communication du ruban.
+void ConnectedBedroom::handle_RGB_LED_strip_effect_update_(int communication_id) {
+  ConnectedBedroomRGBLEDStrip *strip = this->get_RGB_LED_strip_from_communication_id(communication_id);
+  if (strip == nullptr)
+    return;
 
-    // Requête portant sur la gestion de la synchronisation et de l'alimentation.
-    case 3: {
-      switch (getIntFromVector(receivedMessage_, 1, 2)) {
-        case 1:
-          this->write('3');
-          this->write('0');
-          this->write('0');
-          this->write('\n');
-          break;
+  int effect = protocol::UpdateRGBLEDStripEffect::get<0>(this->receivedMessage_);
+  if (effect <= RGB_LED_STRIP_NO_EFFECT || effect >= RGB_LED_STRIP_EFFECTS_COUNT)
+    return;
 
-        case 2:
-          std::string value = "false";
-          if (getIntFromVector(receivedMessage_, 3, 1) == 1)
-            value = "true";
+  uint32_t effect_index = strip->get_effect_index(RGBLEDStripEffects(effect));
+  if (effect_index == 0)
+    return;
 
-          this->call_homeassistant_service("script.arreter_le_systeme_de_domotique_de_la_chambre_de_louis",
-                                           {{"redemarrer", value}});
+  auto call = strip->state->make_call();
+  call.set_transition_length(0);
+  call.set_effect(effect_index);
+  call.set_state(true);
+  {
+    CONNECTED_BEDROOM_PROFILE(PHASE_LIGHT_CALL);
+    call.perform();
+  }
+  strip->confirm_effect(RGBLEDStripEffects(effect));
+}
 
-          break;
-      }
+/// @brief Mise à jour de l'état d'une alarme : armée.
+/// @param communication_id L'identifiant de communication de l'alarme.
+void ConnectedBedroom::handle_alarm_armed_update_(int communication_id) {
+  alarm_control_panel::AlarmControlPanel *alarm = this->get_alarm_from_communication_id_(communication_id);
+  if (alarm == nullptr)
+    return;
 
-      break;
-    }
+  this->stage_update_(communication_id, STAGED_SLOT_STATE, STAGED_ALARM, alarm,
+                      alarm_control_panel::ACP_STATE_ARMED_AWAY);
+  this->remember_state_(communication_id, PERSISTED_ALARM_STATE, alarm_control_panel::ACP_STATE_ARMED_AWAY);
+}
 
-    // Requête de lancement d'une musique.
-    case 4: {
-      std::string url;
-      for (int i = 1; i < this->receivedMessage_.size(); i++)
-        url.push_back(this->receivedMessage_[i]);
+/// @brief Mise à jour de l'état d'une alarme : déclenchée.
+/// @param communication_id L'identifiant de communication de l'alarme.
+void ConnectedBedroom::handle_alarm_triggered_update_(int communication_id) {
+  alarm_control_panel::AlarmControlPanel *alarm = this->get_alarm_from_communication_id_(communication_id);
+  if (alarm == nullptr)
+    return;
 
-      this->call_homeassistant_service("script.jouer_musique_domotique_louis", {{"url", url}});
+  this->stage_update_(communication_id, STAGED_SLOT_STATE, STAGED_ALARM, alarm,
+                      alarm_control_panel::ACP_STATE_TRIGGERED);
+  this->remember_state_(communication_id, PERSISTED_ALARM_STATE, alarm_control_panel::ACP_STATE_TRIGGERED);
+}
 
-      break;
-    }
+/// @brief Mise à jour de la position de la base d'un lance-missile.
+/// @param communication_id L'identifiant de communication de l'alarme.
+void ConnectedBedroom::handle_missile_launcher_base_update_(int communication_id) {
+  number::Number *button = this->get_missile_launcher_base_number_from_communication_id_(communication_id);
+  if (button == nullptr)
+    return;
+
+  this->stage_update_(communication_id, STAGED_SLOT_BASE, STAGED_NUMBER, button,
+                      protocol::UpdateMissileLauncherBase::get<0>(this->receivedMessage_));
+}
+
+/// @brief Mise à jour de l'angle d'un lance-missile.
+/// @param communication_id L'identifiant de communication de l'alarme.
+void ConnectedBedroom::handle_missile_launcher_angle_update_(int communication_id) {
+  number::Number *button = this->get_missile_launcher_angle_number_from_communication_id_(communication_id);
+  if (button == nullptr)
+    return;
+
+  this->stage_update_(communication_id, STAGED_SLOT_ANGLE, STAGED_NUMBER, button,
+                      protocol::UpdateMissileLauncherAngle::get<0>(this->receivedMessage_));
+}
+
+/// @brief Mise à jour du nombre de missiles disponibles d'un lance-missile (un chiffre par emplacement).
+/// @param communication_id L'identifiant de communication de l'alarme.
+void ConnectedBedroom::handle_missile_launcher_missiles_update_(int communication_id) {
+  sensor::Sensor *sensor =
+      this->get_missile_launcher_available_missiles_sensor_from_communication_id_(communication_id);
+  if (sensor == nullptr)
+    return;
+
+  using Frame = protocol::UpdateMissileLauncherMissiles;
+  int count = Frame::get<0>(this->receivedMessage_) + Frame::get<1>(this->receivedMessage_) +
+              Frame::get<2>(this->receivedMessage_);
+  this->stage_update_(communication_id, STAGED_SLOT_MISSILES, STAGED_SENSOR, sensor, count);
+  this->remember_state_(communication_id, PERSISTED_MISSILES_COUNT, count);
+}
+
+/// @brief Mise à jour de la position finale d'un lance-missile après une visée (base puis angle).
+/// @param communication_id L'identifiant de communication de l'alarme.
+void ConnectedBedroom::handle_missile_launcher_aim_update_(int communication_id) {
+  using Frame = protocol::UpdateMissileLauncherAim;
+  number::Number *base = this->get_missile_launcher_base_number_from_communication_id_(communication_id);
+  number::Number *angle = this->get_missile_launcher_angle_number_from_communication_id_(communication_id);
+  if (base != nullptr)
+    this->stage_update_(communication_id, STAGED_SLOT_BASE, STAGED_NUMBER, base, Frame::get<0>(this->receivedMessage_));
+  if (angle != nullptr)
+    this->stage_update_(communication_id, STAGED_SLOT_ANGLE, STAGED_NUMBER, angle,
+                        Frame::get<1>(this->receivedMessage_));
+}
+
+/// @brief Mise à jour du volume d'une télévision.
+/// @param communication_id L'identifiant de communication de la télévision.
+void ConnectedBedroom::handle_television_volume_update_(int communication_id) {
+  ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
+  if (television == nullptr)
+    return;
+
+  int volume = protocol::UpdateTelevisionVolume::get<0>(this->receivedMessage_);
+  this->stage_update_(communication_id, STAGED_SLOT_VOLUME, STAGED_SENSOR, television->volume, volume);
+  if (television->volume_number != nullptr)
+    this->stage_update_(communication_id, STAGED_SLOT_VOLUME_NUMBER, STAGED_NUMBER, television->volume_number, volume);
+  this->remember_state_(communication_id, PERSISTED_TELEVISION_VOLUME, volume);
+}
+
+/// @brief Mise à jour d'une télévision : son coupé.
+/// @param communication_id L'identifiant de communication de la télévision.
+void ConnectedBedroom::handle_television_muted_update_(int communication_id) {
+  ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
+  if (television == nullptr)
+    return;
+
+  this->stage_update_(communication_id, STAGED_SLOT_MUTED, STAGED_SWITCH, television->muted, true);
+  this->remember_state_(communication_id, PERSISTED_TELEVISION_MUTED, 1);
+}
+
+/// @brief Mise à jour d'une télévision : son rétabli.
+/// @param communication_id L'identifiant de communication de la télévision.
+void ConnectedBedroom::handle_television_unmuted_update_(int communication_id) {
+  ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
+  if (television == nullptr)
+    return;
+
+  this->stage_update_(communication_id, STAGED_SLOT_MUTED, STAGED_SWITCH, television->muted, false);
+  this->remember_state_(communication_id, PERSISTED_TELEVISION_MUTED, 0);
+}
+
+/// @brief Mise à jour de l'état d'un capteur binaire.
+/// @param communication_id L'identifiant de communication du capteur.
+void ConnectedBedroom::handle_binary_sensor_update_(int communication_id) {
+  binary_sensor::BinarySensor *binary_sensor = this->get_binary_sensor_from_communication_id_(communication_id);
+  if (binary_sensor == nullptr)
+    return;
+
+  int state = protocol::UpdateBinarySensor::get<0>(this->receivedMessage_);
+
+  // Les automatisations sensibles aux fronts doivent voir chaque transition.
+  if (std::count(this->every_transition_binary_sensors_.begin(), this->every_transition_binary_sensors_.end(),
+                 communication_id) > 0) {
+    CONNECTED_BEDROOM_PROFILE(PHASE_PUBLISH);
+    binary_sensor->publish_state(state);
+    return;
   }
 
-  this->receivedMessage_.clear();
+  this->stage_update_(communication_id, STAGED_SLOT_STATE, STAGED_BINARY_SENSOR, binary_sensor, state);
+}
+
+/// @brief Mise à jour de l'état d'un capteur analogique.
+/// @param communication_id L'identifiant de communication du capteur.
+void ConnectedBedroom::handle_analog_sensor_update_(int communication_id) {
+  sensor::Sensor *analog_sensor = this->get_analog_sensor_from_communication_id_(communication_id);
+  if (analog_sensor == nullptr)
+    return;
+
+  this->stage_update_(communication_id, STAGED_SLOT_STATE, STAGED_SENSOR, analog_sensor,
+                      protocol::UpdateAnalogSensor::get<0>(this->receivedMessage_));
+}
+
+/// @brief Mise à jour de l'état du capteur de température (ancien format : valeurs aux identifiants `II` et `II+1`).
+/// @param communication_id L'identifiant de communication de la première valeur.
+void ConnectedBedroom::handle_temperature_sensor_update_(int communication_id) {
+  using Frame = protocol::UpdateTemperatureSensor;
+  sensor::Sensor *analog_sensor = this->get_analog_sensor_from_communication_id_(communication_id);
+  if (analog_sensor == nullptr)
+    return;
+  this->stage_update_(communication_id, STAGED_SLOT_STATE, STAGED_SENSOR, analog_sensor,
+                      float(Frame::get<0>(this->receivedMessage_)) / float(100));
+
+  analog_sensor = this->get_analog_sensor_from_communication_id_(communication_id + 1);
+  if (analog_sensor == nullptr)
+    return;
+  this->stage_update_(communication_id + 1, STAGED_SLOT_STATE, STAGED_SENSOR, analog_sensor,
+                      float(Frame::get<1>(this->receivedMessage_)) / float(100));
+}
+
+/// @brief Mise à jour d'un capteur à plusieurs valeurs (N valeurs signées sur 5 chiffres, une par emplacement).
+/// @param communication_id L'identifiant de communication du capteur.
+void ConnectedBedroom::handle_multi_value_sensor_update_(int communication_id) {
+  const MultiValueSensor *multi_value_sensor = this->get_multi_value_sensor_from_communication_id_(communication_id);
+  if (multi_value_sensor == nullptr)
+    return;
+
+  using Frame = protocol::UpdateMultiValueSensor;
+  int count = Frame::get<0>(this->receivedMessage_);
+  if (count > MAX_SENSOR_SLOTS ||
+      this->receivedMessage_.size() < Frame::length() + count * protocol::SENSOR_VALUE_WIDTH)
+    return;
+
+  for (int slot = 0; slot < count; slot++) {
+    sensor::Sensor *analog_sensor = multi_value_sensor->sensors[slot];
+    if (analog_sensor == nullptr)
+      continue;
+
+    int position = Frame::length() + slot * protocol::SENSOR_VALUE_WIDTH;
+    int value = protocol::read_digits(this->receivedMessage_, position + 1, protocol::SENSOR_VALUE_WIDTH - 1);
+    if (value < 0)
+      continue;
+    if (this->receivedMessage_[position] == '-')
+      value = -value;
+
+    this->stage_update_(communication_id, slot, STAGED_SENSOR, analog_sensor,
+                        float(value) * multi_value_sensor->scales[slot]);
+  }
+}
+
+/// @brief Requête de l'émission d'un message (`2!...` pour un message prioritaire).
+void ConnectedBedroom::handle_speech_message_(int) {
+  size_t start = protocol::TextMessage::length();
+  bool priority = this->receivedMessage_.size() > start && this->receivedMessage_[start] == '!';
+  if (priority)
+    start++;
+
+  this->queue_speech_(std::string(this->receivedMessage_.begin() + start, this->receivedMessage_.end()), priority);
+}
+
+/// @brief Requête de synchronisation de l'Arduino Mega.
+void ConnectedBedroom::handle_synchronization_request_(int) { this->request_synchronization_(); }
+
+/// @brief Requête d'arrêt (ou de redémarrage) du système de domotique.
+void ConnectedBedroom::handle_shutdown_request_(int) {
+  std::string value = "false";
+  if (protocol::ControlShutdown::get<0>(this->receivedMessage_) == 1)
+    value = "true";
+
+  CONNECTED_BEDROOM_PROFILE(PHASE_HA_SERVICE);
+  this->call_homeassistant_service("script.arreter_le_systeme_de_domotique_de_la_chambre_de_louis",
+                                   {{"redemarrer", value}});
+}
+
+/// @brief Annonce de l'époque de l'Arduino Mega (change à chaque redémarrage de celui-ci).
+void ConnectedBedroom::handle_epoch_(int) {
+  this->set_epoch_(protocol::ControlEpoch::get<0>(this->receivedMessage_));
+}
+
+/// @brief Acquittement d'une trame critique.
+void ConnectedBedroom::handle_acknowledgement_(int) {
+  this->acknowledge_frame_(protocol::ControlAcknowledgement::get<0>(this->receivedMessage_));
+}
+
+/// @brief Réponse à une trame de surveillance de la liaison.
+void ConnectedBedroom::handle_pong_(int) { this->receive_pong_(protocol::ControlPing::get<0>(this->receivedMessage_)); }
+
+/// @brief Nombre de morceaux de longues trames que l'Arduino Mega peut recevoir.
+void ConnectedBedroom::handle_chunk_credit_(int) {
+  this->receive_chunk_credit_(protocol::ControlChunkCredit::get<0>(this->receivedMessage_));
+}
+
+/// @brief Requête de lancement d'une musique.
+void ConnectedBedroom::handle_music_(int) {
+  std::string url(this->receivedMessage_.begin() + protocol::MusicURL::length(), this->receivedMessage_.end());
+
+  CONNECTED_BEDROOM_PROFILE(PHASE_HA_SERVICE);
+  this->call_homeassistant_service("script.jouer_musique_domotique_louis", {{"url", url}});
+}
+
+/// @brief Requête de lancement d'une musique préenregistrée (`5PPP`, index dans `music_presets`).
+void ConnectedBedroom::handle_music_preset_(int) {
+  int index = protocol::MusicPreset::get<0>(this->receivedMessage_);
+  std::string url;
+  if (!this->get_music_preset_(index, url)) {
+    ESP_LOGW(TAG, "Unknown music preset %d.", index);
+    return;
+  }
+
+  CONNECTED_BEDROOM_PROFILE(PHASE_HA_SERVICE);
+  this->call_homeassistant_service("script.jouer_musique_domotique_louis", {{"url", url}});
 }
 
 /// @brief Méthode permettant d'envoyer un message à afficher à l'écran de l'Arduino Mega.
 /// @param title Le titre du message.
 /// @param message Le corps du message.
 void ConnectedBedroom::send_message_to_Arduino_(std::string title, std::string message) {
-  std::replace(title.begin(), title.end(), '/', '.');
-  std::replace(message.begin(), message.end(), '/', '.');
+  if (this->display_columns_ == 0) {
+    std::replace(title.begin(), title.end(), '/', '.');
+    std::replace(message.begin(), message.end(), '/', '.');
 
-  this->write('2');
-  this->write_str(title.c_str());
-  this->write('/');
-  this->write_str(message.c_str());
-  this->write('\n');
+    this->send_bulk_frame(protocol::TextMessage::encode() + title + "/" + message);
+    return;
+  }
+
+  // Message mis en forme pour l'écran : `6titre/ligne|ligne/ligne...`, chaque `/` après le titre commençant une page.
+  title = transliterateForDisplay(title);
+  std::replace(title.begin(), title.end(), '\n', ' ');
+  if (title.size() > this->display_columns_)
+    title.resize(this->display_columns_);
+
+  std::vector<std::string> lines = wrapForDisplay(transliterateForDisplay(message), this->display_columns_,
+                                                  size_t(this->display_rows_) * this->display_max_pages_);
+
+  std::string frame = protocol::DisplayMessage::encode() + title;
+  for (size_t i = 0; i < lines.size(); i++) {
+    frame += (i % this->display_rows_ == 0) ? '/' : '|';
+    frame += lines[i];
+  }
+
+  ESP_LOGD(TAG, "Display message rendered in %u lines (%u bytes).", unsigned(lines.size()), unsigned(frame.size()));
+  this->send_bulk_frame(frame);
+}
+
+/// @brief Définit la géométrie de l'écran de l'Arduino Mega, pour mettre en forme les messages avant leur envoi.
+/// @param columns Le nombre de caractères par ligne.
+/// @param rows Le nombre de lignes du corps du message par page.
+/// @param max_pages Le nombre maximal de pages d'un message.
+void ConnectedBedroom::set_display_geometry(uint8_t columns, uint8_t rows, uint8_t max_pages) {
+  this->display_columns_ = columns;
+  this->display_rows_ = rows;
+  this->display_max_pages_ = max_pages;
 }
 
 /// @brief Met à jour l'état d'un périphérique connecté depuis Home Assistant.
 /// @param entity_id L'identifiant (de Home Assistant) du périphérique.
 /// @param state L'état à mettre à jour.
 void ConnectedBedroom::update_connected_device_state_(std::string entity_id, std::string state) {
+  this->count_ha_callback_();
+
   if (state == "None")
     return;
 
-  this->write('1');
-  this->write_str(addZeros(this->get_communication_id_from_connected_light_entity_id_(entity_id), 2).c_str());
-  this->write('0');
-  this->write('1');
-
-  if (state == "on")
-    this->write('1');
-
-  else
-    this->write('0');
-
-  this->write('\n');
+  this->queue_connected_update_(protocol::UpdateConnectedDevicePower::encode(
+      this->get_communication_id_from_connected_light_entity_id_(entity_id), state == "on"));
 }
 
 /// @brief Met à jour la luminosité d'une ampoule connectée depuis Home Assistant.
 /// @param entity_id L'identifiant (de Home Assistant) du périphérique.
 /// @param state La luminosité à mettre à jour.
 void ConnectedBedroom::update_connected_light_brightness_(std::string entity_id, std::string state) {
+  this->count_ha_callback_();
+
   if (state == "None")
     return;
 
-  this->write('1');
-
   int id = this->get_communication_id_from_connected_light_entity_id_(entity_id);
-  this->write_str(addZeros(id, 2).c_str());
 
   switch (this->get_type_from_connected_light_communication_id_(id)) {
-    case TEMPERATURE_VARIABLE_CONNECTED_LIGHT: {
-      this->write('0');
-      this->write('5');
-      this->write('3');
+    case TEMPERATURE_VARIABLE_CONNECTED_LIGHT:
+      this->queue_connected_update_(protocol::UpdateTemperatureLightBrightness::encode(id, std::stoi(state)));
       break;
-    }
 
-    case COLOR_VARIABLE_CONNECTED_LIGHT: {
-      this->write('0');
-      this->write('6');
-      this->write('4');
+    case COLOR_VARIABLE_CONNECTED_LIGHT:
+      this->queue_connected_update_(protocol::UpdateColorLightBrightness::encode(id, std::stoi(state)));
       break;
-    }
 
+    // Un périphérique binaire n'a pas de luminosité.
     case BINARY_CONNECTED_DEVICE:
       break;
   }
-
-  this->write_str(addZeros(std::stoi(state), 3).c_str());
-  this->write('\n');
 }
 
 /// @brief Met à jour la température de couleur d'une ampoule connectée depuis Home Assistant.
 /// @param entity_id L'identifiant (de Home Assistant) du périphérique.
 /// @param state La température de couleur à mettre à jour.
 void ConnectedBedroom::update_connected_light_temperature_(std::string entity_id, std::string state) {
+  this->count_ha_callback_();
+
   if (state == "None")
     return;
 
-  this->write('1');
-
   int id = this->get_communication_id_from_connected_light_entity_id_(entity_id);
-  this->write_str(addZeros(id, 2).c_str());
 
   switch (this->get_type_from_connected_light_communication_id_(id)) {
-    case TEMPERATURE_VARIABLE_CONNECTED_LIGHT: {
-      this->write('0');
-      this->write('5');
-      this->write('2');
+    case TEMPERATURE_VARIABLE_CONNECTED_LIGHT:
+      this->queue_connected_update_(protocol::UpdateTemperatureLightTemperature::encode(id, std::stoi(state)));
       break;
-    }
 
-    case COLOR_VARIABLE_CONNECTED_LIGHT: {
-      this->write('0');
-      this->write('6');
-      this->write('3');
+    case COLOR_VARIABLE_CONNECTED_LIGHT:
+      this->queue_connected_update_(protocol::UpdateColorLightTemperature::encode(id, std::stoi(state)));
       break;
-    }
 
+    // Un périphérique binaire n'a pas de température de couleur.
     case BINARY_CONNECTED_DEVICE:
       break;
   }
-
-  this->write_str(addZeros(std::stoi(state), 4).c_str());
-
-  this->write('\n');
 }
 
 /// @brief Met à jour la couleur d'une ampoule connectée depuis Home Assistant.
 /// @param entity_id L'identifiant (de Home Assistant) du périphérique.
 /// @param state La couleur à mettre à jour.
 void ConnectedBedroom::update_connected_light_color_(std::string entity_id, std::string state) {
+  this->count_ha_callback_();
+
   if (state == "None")
     return;
 
-  this->write('1');
-
   int id = this->get_communication_id_from_connected_light_entity_id_(entity_id);
-  this->write_str(addZeros(id, 2).c_str());
-
-  this->write('0');
-  this->write('6');
-  this->write('2');
 
   std::istringstream ss(state);
   char discard;
   int r, g, b;
   ss >> discard >> r >> discard >> g >> discard >> b >> discard;
 
-  this->write_str(addZeros(r, 3).c_str());
-  this->write_str(addZeros(g, 3).c_str());
-  this->write_str(addZeros(b, 3).c_str());
+  this->queue_connected_update_(protocol::UpdateColorLightColor::encode(id, r, g, b));
+}
 
-  this->write('\n');
+/// @brief Met en attente une mise à jour d'un périphérique connecté : les mises à jour reçues de Home Assistant pendant
+/// une même itération (une scène par exemple) sont envoyées ensemble par `loop()`.
+/// @param frame La trame de la mise à jour.
+void ConnectedBedroom::queue_connected_update_(const std::string &frame) {
+  if (!this->batch_frames_) {
+    this->send_frame(frame);
+    return;
+  }
+
+  this->pending_connected_updates_.push_back(frame);
+}
+
+/// @brief Envoie les mises à jour des périphériques connectés en attente, regroupées dans des trames `8NN` d'au plus
+/// `protocol::MEGA_LINE_MAX_LENGTH` octets. Une mise à jour seule est envoyée dans sa propre trame.
+void ConnectedBedroom::send_connected_updates_() {
+  std::string records;
+  uint8_t count = 0;
+
+  for (size_t i = 0; i <= this->pending_connected_updates_.size(); i++) {
+    bool last = i == this->pending_connected_updates_.size();
+    size_t record_length =
+        last ? 0 : protocol::BatchRecordLength::length() + this->pending_connected_updates_[i].size();
+
+    if (count > 0 && (last || count == protocol::MAX_BATCH_RECORDS ||
+                      protocol::Batch::length() + records.size() + record_length > protocol::MEGA_LINE_MAX_LENGTH)) {
+      if (count == 1)
+        this->send_frame(this->pending_connected_updates_[i - 1]);
+      else
+        this->send_frame(protocol::Batch::encode(count) + records);
+
+      records.clear();
+      count = 0;
+    }
+
+    if (last)
+      break;
+
+    protocol::BatchRecordLength::append(records, this->pending_connected_updates_[i].size());
+    records += this->pending_connected_updates_[i];
+    count++;
+  }
+
+  this->pending_connected_updates_.clear();
 }
 
+/// @brief Active le regroupement des mises à jour des périphériques connectés dans des trames `8NN` (l'Arduino Mega
+/// doit les reconnaître).
+/// @param batch_frames `true` pour regrouper les mises à jour.
+void ConnectedBedroom::set_batch_frames(bool batch_frames) { this->batch_frames_ = batch_frames; }
+
 /// @brief Affiche la configuration actuelle du composant externe.
 void ConnectedBedroom::dump_config() {
   ESP_LOGCONFIG(TAG, "Connected bedroom");
+  if (this->heartbeat_interval_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Heartbeat interval: %u ms", this->heartbeat_interval_);
+    ESP_LOGCONFIG(TAG, "  Max missed heartbeats: %u", this->max_missed_heartbeats_);
+    LOG_SENSOR("  ", "RTT", this->rtt_sensor_);
+    LOG_SENSOR("  ", "Jitter", this->jitter_sensor_);
+    LOG_BINARY_SENSOR("  ", "Link", this->link_sensor_);
+  }
+
+  ESP_LOGCONFIG(TAG, "  Music presets: %u", this->music_presets_count_);
+  ESP_LOGCONFIG(TAG, "  Speech: min interval %u ms, %u characters/s", this->speech_min_interval_,
+                this->speech_characters_per_second_);
+  if (this->batch_frames_)
+    ESP_LOGCONFIG(TAG, "  Batch frames: up to %u bytes", unsigned(protocol::MEGA_LINE_MAX_LENGTH));
+  if (this->chunk_size_ > 0)
+    ESP_LOGCONFIG(TAG, "  Chunked transmit: %u bytes per chunk, initial credit %u, credit timeout %u ms",
+                  this->chunk_size_, this->initial_chunk_credit_, this->chunk_credit_timeout_);
+  if (this->display_columns_ > 0)
+    ESP_LOGCONFIG(TAG, "  Display: %u columns, %u rows, %u pages", this->display_columns_, this->display_rows_,
+                  this->display_max_pages_);
 
   ESP_LOGCONFIG(TAG, "  Analog sensors:");
   for (auto entity : this->analog_sensors_) {
@@ -634,10 +1181,23 @@ void ConnectedBedroom::dump_config() {
     LOG_SENSOR("      ", "", entity.second);
   }
 
+  ESP_LOGCONFIG(TAG, "  Multi-value sensors:");
+  for (auto &entity : this->multi_value_sensors_) {
+    ESP_LOGCONFIG(TAG, "    Communication id: %d", entity.communication_id);
+    for (uint8_t slot = 0; slot < MAX_SENSOR_SLOTS; slot++) {
+      if (entity.sensors[slot] != nullptr)
+        ESP_LOGCONFIG(TAG, "      Slot %u: '%s' (scale %f)", slot, entity.sensors[slot]->get_name().c_str(),
+                      entity.scales[slot]);
+    }
+  }
+
   ESP_LOGCONFIG(TAG, "  Binary sensors:");
   for (auto entity : this->binary_sensors_) {
     ESP_LOGCONFIG(TAG, "    Communication id: %d", entity.first);
     LOG_BINARY_SENSOR("      ", "", entity.second);
+    if (std::count(this->every_transition_binary_sensors_.begin(), this->every_transition_binary_sensors_.end(),
+                   entity.first) > 0)
+      ESP_LOGCONFIG(TAG, "      Publishes every transition");
   }
 
   ESP_LOGCONFIG(TAG, "  Switches:");
@@ -662,6 +1222,12 @@ void ConnectedBedroom::dump_config() {
     ESP_LOGCONFIG(TAG, "      '%d'", entity.second->state->get_name());
   }
 
+  ESP_LOGCONFIG(TAG, "  Addressable LED strips:");
+  for (auto entity : this->addressable_LED_strips_) {
+    ESP_LOGCONFIG(TAG, "    Communication id: %d", entity.first);
+    ESP_LOGCONFIG(TAG, "      LEDs: %d", entity.second->size());
+  }
+
   ESP_LOGCONFIG(TAG, "  Connected lights:");
   for (auto entity : this->connected_lights_) {
     ESP_LOGCONFIG(TAG, "    Communication id: %d", std::get<0>(entity));
@@ -676,11 +1242,41 @@ void ConnectedBedroom::add_analog_sensor(int communication_id, sensor::Sensor *a
   this->analog_sensors_.push_back(std::make_pair(communication_id, analog_sensor));
 }
 
+/// @brief Ajoute un capteur analogique correspondant à une valeur d'un capteur à plusieurs valeurs.
+/// @param communication_id L'identifiant unique du capteur à plusieurs valeurs.
+/// @param slot L'emplacement de la valeur dans la trame de mise à jour.
+/// @param scale Le facteur appliqué à la valeur reçue.
+/// @param analog_sensor L'objet du capteur.
+void ConnectedBedroom::add_analog_sensor_slot(int communication_id, uint8_t slot, float scale,
+                                              sensor::Sensor *analog_sensor) {
+  if (slot >= MAX_SENSOR_SLOTS)
+    return;
+
+  MultiValueSensor *multi_value_sensor = nullptr;
+  for (auto &entity : this->multi_value_sensors_) {
+    if (entity.communication_id == communication_id)
+      multi_value_sensor = &entity;
+  }
+
+  if (multi_value_sensor == nullptr) {
+    this->multi_value_sensors_.push_back(MultiValueSensor{communication_id, {}, {}});
+    multi_value_sensor = &this->multi_value_sensors_.back();
+  }
+
+  multi_value_sensor->sensors[slot] = analog_sensor;
+  multi_value_sensor->scales[slot] = scale;
+}
+
 /// @brief Ajoute un capteur binaire à la liste des périphériques connectés.
 /// @param communication_id L'identifiant unique utilisé dans la communication avec l'Arduino méga.
 /// @param binary_sensor L'objet du capteur.
-void ConnectedBedroom::add_binary_sensor(int communication_id, binary_sensor::BinarySensor *binary_sensor) {
+/// @param publish_every_transition `true` pour publier chaque état reçu, même s'il est suivi d'un autre état dans la
+/// même lecture des trames (sinon, seul le dernier état est publié).
+void ConnectedBedroom::add_binary_sensor(int communication_id, binary_sensor::BinarySensor *binary_sensor,
+                                         bool publish_every_transition) {
   this->binary_sensors_.push_back(std::make_pair(communication_id, binary_sensor));
+  if (publish_every_transition)
+    this->every_transition_binary_sensors_.push_back(communication_id);
 }
 
 /// @brief Ajoute un commutateur à la liste des périphériques connectés.
@@ -737,70 +1333,1131 @@ void ConnectedBedroom::add_alarm_missile_launcher_angle_number(int communication
                      return std::get<0>(element) == communication_id;
                    });
 
-  if (it != alarms_.end()) {
-    std::get<3>(*it) = number;
-  } else {
-    this->alarms_.push_back(std::make_tuple(communication_id, nullptr, nullptr, number, nullptr, nullptr));
+  if (it != alarms_.end()) {
+    std::get<3>(*it) = number;
+  } else {
+    this->alarms_.push_back(std::make_tuple(communication_id, nullptr, nullptr, number, nullptr, nullptr));
+  }
+}
+
+/// @brief Ajoute un bouton de tir d'un missile d'un lance-missile à la liste.
+/// @param communication_id L'identifiant unique de l'alarme, utilisé dans la communication avec l'Arduino méga.
+/// @param button L'objet du bouton.
+void ConnectedBedroom::add_alarm_missile_launcher_launch_button(int communication_id, button::Button *button) {
+  auto it =
+      std::find_if(alarms_.begin(), alarms_.end(),
+                   [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
+                                                       number::Number *, button::Button *, sensor::Sensor *> &element) {
+                     return std::get<0>(element) == communication_id;
+                   });
+
+  if (it != alarms_.end()) {
+    std::get<4>(*it) = button;
+  } else {
+    this->alarms_.push_back(std::make_tuple(communication_id, nullptr, nullptr, nullptr, button, nullptr));
+  }
+}
+
+/// @brief Ajoute un capteur de missiles chargés d'un lance-missile à la liste.
+/// @param communication_id L'identifiant unique de l'alarme, utilisé dans la communication avec l'Arduino méga.
+/// @param sensor L'objet du capteur.
+void ConnectedBedroom::add_alarm_missile_launcher_available_missiles_sensor(int communication_id,
+                                                                            sensor::Sensor *sensor) {
+  auto it =
+      std::find_if(alarms_.begin(), alarms_.end(),
+                   [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
+                                                       number::Number *, button::Button *, sensor::Sensor *> &element) {
+                     return std::get<0>(element) == communication_id;
+                   });
+
+  if (it != alarms_.end()) {
+    std::get<5>(*it) = sensor;
+  } else {
+    this->alarms_.push_back(std::make_tuple(communication_id, nullptr, nullptr, nullptr, nullptr, sensor));
+  }
+}
+
+/// @brief Ajoute une télévision à la liste des périphériques connectés.
+/// @param communication_id L'identifiant unique utilisée dans la communication avec l'Arduino méga.
+/// @param television L'objet de la télévision.
+void ConnectedBedroom::add_television(int communication_id, ConnectedBedroomTelevision *television) {
+  this->televisions_.push_back(std::make_pair(communication_id, television));
+}
+
+/// @brief Ajoute un périphérique connecté depuis Home Assistant à la liste des périphériques connectés.
+/// @param communication_id L'identifiant unique utilisée dans la communication avec l'Arduino méga.
+/// @param entity_id L'identifiant de Home Assistant, du périphérique.
+/// @param type Le type du périphérique.
+void ConnectedBedroom::add_connected_device(int communication_id, std::string entity_id, ConnectedDeviceTypes type) {
+  this->connected_lights_.push_back(std::make_tuple(communication_id, entity_id, type));
+}
+
+/// @brief Ajoute un ruban de DEL RVB à la liste des périphériques connectés.
+/// @param communication_id L'identifiant unique utilisée dans la communication avec l'Arduino méga.
+/// @param light L'objet du ruban de DEL RVB.
+void ConnectedBedroom::add_RGB_LED_strip(int communication_id, ConnectedBedroomRGBLEDStrip *light) {
+  this->RGB_LED_strips_.push_back(std::make_pair(communication_id, light));
+}
+
+/// @brief Ajoute un ruban de DEL adressables à la liste des périphériques connectés.
+/// @param communication_id L'identifiant unique utilisée dans la communication avec l'Arduino méga.
+/// @param light L'objet du ruban de DEL adressables.
+void ConnectedBedroom::add_addressable_LED_strip(int communication_id, ConnectedBedroomAddressableLEDStrip *light) {
+  this->addressable_LED_strips_.push_back(std::make_pair(communication_id, light));
+}
+
+/// @brief Active ou désactive la mémorisation des derniers états connus des périphériques.
+/// @param restore_states `true` pour publier les derniers états connus au démarrage.
+void ConnectedBedroom::set_restore_states(bool restore_states) { this->restore_states_ = restore_states; }
+
+/// @brief Définit l'intervalle minimal entre deux enregistrements des derniers états connus.
+/// @param state_save_interval L'intervalle en millisecondes.
+void ConnectedBedroom::set_state_save_interval(uint32_t state_save_interval) {
+  this->state_save_interval_ = state_save_interval;
+}
+
+/// @brief Définit la clé utilisée pour enregistrer les derniers états connus dans la mémoire persistante.
+/// @param preference_key La clé (unique pour chaque instance du composant).
+void ConnectedBedroom::set_preference_key(const std::string &preference_key) {
+  this->preference_key_ = preference_key;
+}
+
+/// @brief Définit le suffixe ajouté au nom des services du composant, pour distinguer ceux de chaque microcontrôleur
+/// d'un bus partagé.
+/// @param service_suffix Le suffixe (vide pour une liaison UART dédiée).
+void ConnectedBedroom::set_service_suffix(const std::string &service_suffix) {
+  this->service_suffix_ = service_suffix;
+}
+
+/// @brief Publie les derniers états connus, lus depuis la mémoire persistante. Ils seront ensuite corrigés par les
+/// mises à jour envoyées par l'Arduino Mega.
+void ConnectedBedroom::publish_persisted_states_() {
+  if (!this->states_preference_.load(&this->persisted_states_) ||
+      this->persisted_states_.count > MAX_PERSISTED_STATES ||
+      this->persisted_states_.version_count > MAX_PERSISTED_STATES) {
+    this->persisted_states_.count = 0;
+    this->persisted_states_.epoch = UNKNOWN_EPOCH;
+    this->persisted_states_.version_count = 0;
+    return;
+  }
+
+  // Seules les versions des périphériques dont l'état a été restauré restent valables : les autres seront renvoyés
+  // en entier lors de la synchronisation.
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < this->persisted_states_.version_count; i++) {
+    const DeviceVersion &device_version = this->persisted_states_.versions[i];
+    for (uint8_t j = 0; j < this->persisted_states_.count; j++) {
+      if (this->persisted_states_.states[j].communication_id == device_version.communication_id) {
+        this->persisted_states_.versions[kept++] = device_version;
+        break;
+      }
+    }
+  }
+  this->persisted_states_.version_count = kept;
+
+  ESP_LOGD(TAG, "Restoring %u persisted states.", this->persisted_states_.count);
+
+  for (uint8_t i = 0; i < this->persisted_states_.count; i++) {
+    const PersistedState &persisted = this->persisted_states_.states[i];
+    int communication_id = persisted.communication_id;
+
+    switch (persisted.kind) {
+      case PERSISTED_SWITCH_STATE: {
+        switch_::Switch *switch_ = this->get_switch_from_communication_id_(communication_id);
+        if (switch_ != nullptr)
+          switch_->publish_state(persisted.values[0]);
+        break;
+      }
+
+      case PERSISTED_ALARM_STATE: {
+        alarm_control_panel::AlarmControlPanel *alarm = this->get_alarm_from_communication_id_(communication_id);
+        if (alarm != nullptr)
+          alarm->publish_state(static_cast<alarm_control_panel::AlarmControlPanelState>(persisted.values[0]));
+        break;
+      }
+
+      case PERSISTED_MISSILES_COUNT: {
+        sensor::Sensor *sensor =
+            this->get_missile_launcher_available_missiles_sensor_from_communication_id_(communication_id);
+        if (sensor != nullptr)
+          sensor->publish_state(float(persisted.values[0]));
+        break;
+      }
+
+      case PERSISTED_TELEVISION_STATE: {
+        ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
+        if (television != nullptr)
+          television->state->publish_state(persisted.values[0]);
+        break;
+      }
+
+      case PERSISTED_TELEVISION_VOLUME: {
+        ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
+        if (television == nullptr)
+          break;
+        television->volume->publish_state(persisted.values[0]);
+        if (television->volume_number != nullptr)
+          television->volume_number->publish_state(persisted.values[0]);
+        break;
+      }
+
+      case PERSISTED_TELEVISION_MUTED: {
+        ConnectedBedroomTelevision *television = this->get_television_from_communication_id_(communication_id);
+        if (television != nullptr)
+          television->muted->publish_state(persisted.values[0]);
+        break;
+      }
+
+      case PERSISTED_RGB_LED_STRIP_STATE: {
+        ConnectedBedroomRGBLEDStrip *strip = this->get_RGB_LED_strip_from_communication_id(communication_id);
+        if (strip == nullptr)
+          break;
+        auto call = strip->state->make_call();
+        call.set_transition_length(0);
+        call.set_state(persisted.values[0]);
+        call.perform();
+        strip->confirm_power(persisted.values[0]);
+        break;
+      }
+
+      case PERSISTED_RGB_LED_STRIP_COLOR: {
+        ConnectedBedroomRGBLEDStrip *strip = this->get_RGB_LED_strip_from_communication_id(communication_id);
+        if (strip == nullptr)
+          break;
+        auto call = strip->state->make_call();
+        call.set_transition_length(0);
+        call.set_rgb(float(persisted.values[0]) / 255.0f, float(persisted.values[1]) / 255.0f,
+                     float(persisted.values[2]) / 255.0f);
+        call.set_effect(0u);
+        call.perform();
+        strip->confirm_color();
+        break;
+      }
+    }
+  }
+}
+
+/// @brief Met à jour le dernier état connu d'un périphérique, confirmé par l'Arduino Mega. L'enregistrement dans la
+/// mémoire persistante est différé dans `loop()`.
+/// @param communication_id L'identifiant unique du périphérique.
+/// @param kind Le type de l'état.
+/// @param value_1 La première valeur de l'état.
+/// @param value_2 La deuxième valeur de l'état (couleurs uniquement).
+/// @param value_3 La troisième valeur de l'état (couleurs uniquement).
+void ConnectedBedroom::remember_state_(int communication_id, PersistedStateKinds kind, uint8_t value_1,
+                                       uint8_t value_2, uint8_t value_3) {
+  if (!this->restore_states_)
+    return;
+
+  PersistedState *persisted = nullptr;
+  for (uint8_t i = 0; i < this->persisted_states_.count; i++) {
+    PersistedState &candidate = this->persisted_states_.states[i];
+    if (candidate.communication_id == communication_id && candidate.kind == kind) {
+      persisted = &candidate;
+      break;
+    }
+  }
+
+  if (persisted == nullptr) {
+    if (this->persisted_states_.count >= MAX_PERSISTED_STATES) {
+      if (!this->states_overflow_logged_) {
+        ESP_LOGW(TAG, "Too many states to persist, ignoring device %d.", communication_id);
+        this->states_overflow_logged_ = true;
+      }
+      return;
+    }
+
+    persisted = &this->persisted_states_.states[this->persisted_states_.count++];
+    persisted->communication_id = communication_id;
+    persisted->kind = kind;
+  }
+
+  else if (persisted->values[0] == value_1 && persisted->values[1] == value_2 && persisted->values[2] == value_3)
+    return;
+
+  persisted->values[0] = value_1;
+  persisted->values[1] = value_2;
+  persisted->values[2] = value_3;
+  this->states_dirty_ = true;
+}
+
+/// @brief Envoie une requête de synchronisation à l'Arduino Mega. Si l'époque de l'Arduino Mega est connue, les
+/// versions des états déjà connus sont jointes (`IIVVV` pour chaque périphérique) afin qu'il n'envoie que les états
+/// modifiés depuis. Sinon (ou si l'époque ne correspond pas), l'Arduino Mega envoie tous les états. Les versions sont
+/// réparties sur plusieurs trames pour respecter la taille du tampon de réception de l'Arduino Mega : des trames
+/// `308EEE...` qu'il mémorise, puis une dernière trame `301EEE...` qui déclenche la synchronisation.
+void ConnectedBedroom::request_synchronization_() {
+  uint8_t version_count = this->persisted_states_.version_count;
+  if (this->persisted_states_.epoch == UNKNOWN_EPOCH || version_count == 0) {
+    this->send_frame(protocol::ControlFullSynchronization::encode());
+    return;
+  }
+
+  for (uint8_t first = 0; first < version_count; first += protocol::DEVICE_VERSION_RECORDS_PER_FRAME) {
+    uint8_t end = std::min<uint8_t>(version_count, first + protocol::DEVICE_VERSION_RECORDS_PER_FRAME);
+    std::string frame = end == version_count
+                            ? protocol::ControlDeltaSynchronization::encode(this->persisted_states_.epoch)
+                            : protocol::ControlDeltaSynchronizationPart::encode(this->persisted_states_.epoch);
+
+    for (uint8_t i = first; i < end; i++)
+      protocol::DeviceVersionRecord::append(frame, this->persisted_states_.versions[i].communication_id,
+                                            this->persisted_states_.versions[i].version);
+
+    this->send_frame(frame);
+  }
+}
+
+/// @brief Mémorise la version de l'état d'un périphérique, reçue à la fin d'une mise à jour.
+/// @param communication_id L'identifiant unique du périphérique.
+/// @param version La version de l'état.
+void ConnectedBedroom::remember_version_(int communication_id, uint16_t version) {
+  DeviceVersion *device_version = nullptr;
+  for (uint8_t i = 0; i < this->persisted_states_.version_count; i++) {
+    if (this->persisted_states_.versions[i].communication_id == communication_id) {
+      device_version = &this->persisted_states_.versions[i];
+      break;
+    }
+  }
+
+  if (device_version == nullptr) {
+    if (this->persisted_states_.version_count >= MAX_PERSISTED_STATES)
+      return;
+
+    device_version = &this->persisted_states_.versions[this->persisted_states_.version_count++];
+    device_version->communication_id = communication_id;
+  }
+
+  else if (device_version->version == version)
+    return;
+
+  device_version->version = version;
+  if (this->restore_states_)
+    this->states_dirty_ = true;
+}
+
+/// @brief Définit l'époque de l'Arduino Mega. Les versions connues ne sont plus valables si elle a changé.
+/// @param epoch L'époque annoncée par l'Arduino Mega.
+void ConnectedBedroom::set_epoch_(uint16_t epoch) {
+  if (this->persisted_states_.epoch == epoch)
+    return;
+
+  ESP_LOGD(TAG, "New Arduino epoch: %u.", epoch);
+
+  this->persisted_states_.epoch = epoch;
+  this->persisted_states_.version_count = 0;
+  if (this->restore_states_)
+    this->states_dirty_ = true;
+
+  // L'Arduino Mega a redémarré : les pixels des rubans de DEL adressables doivent tous être renvoyés.
+  for (auto entity : this->addressable_LED_strips_)
+    entity.second->force_full_refresh();
+
+  // Les morceaux déjà reçus de la longue trame en cours sont perdus : elle est renvoyée depuis le début.
+  this->chunk_index_ = 0;
+  this->chunk_credit_ = this->initial_chunk_credit_;
+  this->last_chunk_credit_ = millis();
+}
+
+/// @brief Active ou désactive la livraison fiable (numérotation, acquittement et renvoi) des trames critiques.
+/// @param reliable_commands `true` pour activer la livraison fiable.
+void ConnectedBedroom::set_reliable_commands(bool reliable_commands) { this->reliable_commands_ = reliable_commands; }
+
+/// @brief Définit le délai après lequel une trame critique non acquittée est renvoyée.
+/// @param retransmit_timeout Le délai en millisecondes.
+void ConnectedBedroom::set_retransmit_timeout(uint32_t retransmit_timeout) {
+  this->retransmit_timeout_ = retransmit_timeout;
+}
+
+/// @brief Définit le nombre maximal de renvois d'une trame critique avant de demander une synchronisation complète.
+/// @param max_retransmits Le nombre maximal de renvois.
+void ConnectedBedroom::set_max_retransmits(uint8_t max_retransmits) { this->max_retransmits_ = max_retransmits; }
+
+/// @brief Définit l'intervalle entre deux trames de surveillance de la liaison (`0` pour désactiver la surveillance).
+/// @param heartbeat_interval L'intervalle en millisecondes.
+void ConnectedBedroom::set_heartbeat_interval(uint32_t heartbeat_interval) {
+  this->heartbeat_interval_ = heartbeat_interval;
+}
+
+/// @brief Définit le nombre de trames de surveillance sans réponse après lequel la liaison est considérée perdue.
+/// @param max_missed_heartbeats Le nombre de trames sans réponse.
+void ConnectedBedroom::set_max_missed_heartbeats(uint8_t max_missed_heartbeats) {
+  this->max_missed_heartbeats_ = max_missed_heartbeats;
+}
+
+/// @brief Définit le capteur du temps d'aller-retour de la liaison.
+/// @param rtt_sensor L'objet du capteur.
+void ConnectedBedroom::set_rtt_sensor(sensor::Sensor *rtt_sensor) { this->rtt_sensor_ = rtt_sensor; }
+
+/// @brief Définit le capteur de la gigue du temps d'aller-retour de la liaison.
+/// @param jitter_sensor L'objet du capteur.
+void ConnectedBedroom::set_jitter_sensor(sensor::Sensor *jitter_sensor) { this->jitter_sensor_ = jitter_sensor; }
+
+/// @brief Définit le capteur binaire de l'état de la liaison.
+/// @param link_sensor L'objet du capteur.
+void ConnectedBedroom::set_link_sensor(binary_sensor::BinarySensor *link_sensor) { this->link_sensor_ = link_sensor; }
+
+/// @brief Envoie périodiquement une trame de surveillance (`305SSS`, renvoyée telle quelle par l'Arduino Mega),
+/// détecte la perte de la liaison et déclenche la synchronisation différée après son rétablissement.
+void ConnectedBedroom::process_heartbeat_() {
+  uint32_t now = millis();
+
+  if (this->resync_pending_ && now - this->last_automatic_resync_ >= this->resync_backoff_) {
+    this->resync_pending_ = false;
+    this->last_automatic_resync_ = now;
+    this->resync_backoff_ = std::min(this->resync_backoff_ * 2, MAX_RESYNC_BACKOFF);
+    this->request_synchronization_();
+  }
+
+  // La temporisation est réinitialisée lorsque la liaison est stable.
+  if (this->link_up_ && !this->resync_pending_ && now - this->link_up_since_ >= MAX_RESYNC_BACKOFF)
+    this->resync_backoff_ = MIN_RESYNC_BACKOFF;
+
+  if (now - this->ping_sent_at_ < this->heartbeat_interval_)
+    return;
+
+  if (this->ping_pending_ && this->missed_heartbeats_ < UINT8_MAX)
+    this->missed_heartbeats_++;
+
+  if (this->link_up_ && this->missed_heartbeats_ >= this->max_missed_heartbeats_) {
+    ESP_LOGW(TAG, "No answer from Arduino after %u heartbeats, link lost.", this->missed_heartbeats_);
+    this->set_link_state_(false);
+  }
+
+  this->ping_sequence_ = (this->ping_sequence_ + 1) % 1000;
+  this->ping_sent_at_ = now;
+  this->ping_pending_ = true;
+  this->send_frame(protocol::ControlPing::encode(this->ping_sequence_));
+}
+
+/// @brief Traite la réponse de l'Arduino Mega à une trame de surveillance : mesure du temps d'aller-retour et de sa
+/// gigue (moyenne glissante des écarts successifs, comme dans RTP).
+/// @param sequence Le numéro de la trame de surveillance.
+void ConnectedBedroom::receive_pong_(uint16_t sequence) {
+  if (!this->ping_pending_ || sequence != this->ping_sequence_)
+    return;
+
+  this->ping_pending_ = false;
+
+  float rtt = float(millis() - this->ping_sent_at_);
+  if (!std::isnan(this->last_rtt_))
+    this->jitter_ += (std::fabs(rtt - this->last_rtt_) - this->jitter_) / 16.0f;
+  this->last_rtt_ = rtt;
+
+  if (this->rtt_sensor_ != nullptr)
+    this->rtt_sensor_->publish_state(rtt);
+  if (this->jitter_sensor_ != nullptr)
+    this->jitter_sensor_->publish_state(this->jitter_);
+}
+
+/// @brief Signale la réception d'une trame de l'Arduino Mega, preuve que la liaison fonctionne.
+void ConnectedBedroom::mark_link_alive_() {
+  this->missed_heartbeats_ = 0;
+
+  if (this->link_sensor_ != nullptr && !this->link_sensor_->has_state())
+    this->link_sensor_->publish_state(true);
+
+  if (!this->link_up_) {
+    ESP_LOGI(TAG, "Link with Arduino restored.");
+    this->set_link_state_(true);
+
+    // Synchronisation après le rétablissement, limitée par une temporisation croissante si la liaison est instable.
+    this->resync_pending_ = true;
+  }
+}
+
+/// @brief Met à jour l'état de la liaison. Lorsqu'elle est perdue, les capteurs, capteurs binaires et nombres sont
+/// rendus inconnus pour ne pas exposer des valeurs périmées. Les interrupteurs, alarmes, lumières et télévisions ne
+/// peuvent pas l'être : le capteur binaire `link` indique alors si leur état est à jour.
+/// @param link_up L'état de la liaison.
+void ConnectedBedroom::set_link_state_(bool link_up) {
+  this->link_up_ = link_up;
+  this->link_up_since_ = millis();
+
+  if (this->link_sensor_ != nullptr)
+    this->link_sensor_->publish_state(link_up);
+
+  if (link_up)
+    return;
+
+  this->ping_pending_ = false;
+  this->last_rtt_ = NAN;
+
+  // Les états rendus inconnus ne seraient pas renvoyés par une synchronisation différentielle : la synchronisation qui
+  // suivra le rétablissement de la liaison sera complète.
+  this->persisted_states_.version_count = 0;
+
+  for (auto entity : this->analog_sensors_)
+    entity.second->publish_state(NAN);
+
+  for (auto &entity : this->multi_value_sensors_) {
+    for (auto analog_sensor : entity.sensors) {
+      if (analog_sensor != nullptr)
+        analog_sensor->publish_state(NAN);
+    }
+  }
+
+  for (auto entity : this->binary_sensors_)
+    entity.second->invalidate_state();
+
+  for (auto entity : this->alarms_) {
+    if (std::get<2>(entity) != nullptr)
+      std::get<2>(entity)->publish_state(NAN);
+    if (std::get<3>(entity) != nullptr)
+      std::get<3>(entity)->publish_state(NAN);
+    if (std::get<5>(entity) != nullptr)
+      std::get<5>(entity)->publish_state(NAN);
+  }
+
+  for (auto entity : this->televisions_) {
+    entity.second->volume->publish_state(NAN);
+    if (entity.second->volume_number != nullptr)
+      entity.second->volume_number->publish_state(NAN);
+  }
+
+  if (this->rtt_sensor_ != nullptr)
+    this->rtt_sensor_->publish_state(NAN);
+  if (this->jitter_sensor_ != nullptr)
+    this->jitter_sensor_->publish_state(NAN);
+}
+
+/// @brief Retourne le débit de la liaison avec l'Arduino Mega (10 bits par octet avec les bits de départ et d'arrêt).
+/// @return Le débit en octets par seconde.
+uint32_t ConnectedBedroom::get_link_byte_rate() const { return this->parent_->get_baud_rate() / 10; }
+
+/// @brief Envoie une trame à l'Arduino Mega.
+/// @param frame La trame, sans le retour à la ligne final.
+/// @param traced_communication_id L'identifiant unique du périphérique dont la commande tracée est portée par la trame
+/// (`-1` si la trame ne porte pas de commande tracée).
+void ConnectedBedroom::send_frame(const std::string &frame, int traced_communication_id) {
+  this->write_str(frame.c_str());
+  this->write('\n');
+  if (traced_communication_id >= 0)
+    this->trace_command_written_(traced_communication_id);
+
+#ifdef USE_CONNECTED_BEDROOM_SOAK_TEST
+  this->link_statistics_.tx_frames++;
+  this->link_statistics_.tx_bytes += frame.size() + 1;
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_RECORDER
+  static const uint8_t END_OF_FRAME = '\n';
+  this->record_traffic_(TRAFFIC_TX, reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+  this->record_traffic_(TRAFFIC_TX, &END_OF_FRAME, 1);
+#endif
+}
+
+/// @brief Définit la durée minimale entre deux messages prononcés par l'enceinte.
+/// @param speech_min_interval La durée en millisecondes.
+void ConnectedBedroom::set_speech_min_interval(uint32_t speech_min_interval) {
+  this->speech_min_interval_ = speech_min_interval;
+}
+
+/// @brief Définit la vitesse d'élocution de l'enceinte, utilisée pour estimer la durée de chaque message.
+/// @param speech_characters_per_second Le nombre de caractères prononcés par seconde (`0` : pas d'estimation).
+void ConnectedBedroom::set_speech_characters_per_second(uint8_t speech_characters_per_second) {
+  this->speech_characters_per_second_ = speech_characters_per_second;
+}
+
+/// @brief Ajoute un message à la file des messages à prononcer. Un message identique à un message en attente (ou en
+/// cours d'émission) est ignoré, et un message prioritaire remplace les messages non prioritaires en attente.
+/// @param message Le message.
+/// @param priority `true` si le message est prioritaire.
+void ConnectedBedroom::queue_speech_(const std::string &message, bool priority) {
+  if (int32_t(millis() - this->next_speech_at_) < 0 && message == this->last_speech_) {
+    ESP_LOGD(TAG, "Message '%s' is already being spoken, ignored.", message.c_str());
+    return;
+  }
+
+  for (auto &pending : this->speech_queue_) {
+    if (pending.message == message) {
+      pending.priority |= priority;
+      ESP_LOGD(TAG, "Message '%s' is already queued, merged.", message.c_str());
+      return;
+    }
+  }
+
+  if (priority) {
+    this->speech_queue_.erase(std::remove_if(this->speech_queue_.begin(), this->speech_queue_.end(),
+                                             [](const PendingSpeech &pending) { return !pending.priority; }),
+                              this->speech_queue_.end());
+  } else if (!this->speech_queue_.empty() && this->speech_queue_.front().priority) {
+    ESP_LOGD(TAG, "Message '%s' superseded by a priority message, dropped.", message.c_str());
+    return;
+  }
+
+  if (this->speech_queue_.size() >= SPEECH_QUEUE_SIZE) {
+    ESP_LOGW(TAG, "Speech queue full, dropping message '%s'.", this->speech_queue_.front().message.c_str());
+    this->speech_queue_.erase(this->speech_queue_.begin());
+  }
+
+  this->speech_queue_.push_back(PendingSpeech{message, priority});
+}
+
+/// @brief Fait prononcer le premier message de la file, une fois le message précédent terminé.
+void ConnectedBedroom::process_speech_queue_() {
+  uint32_t now = millis();
+  if (int32_t(now - this->next_speech_at_) < 0)
+    return;
+
+  PendingSpeech speech = this->speech_queue_.front();
+  this->speech_queue_.erase(this->speech_queue_.begin());
+
+  // Le message suivant attend la fin estimée de celui-ci (au moins la durée minimale).
+  uint32_t duration = this->speech_min_interval_;
+  if (this->speech_characters_per_second_ > 0)
+    duration = std::max<uint32_t>(duration, speech.message.size() * 1000 / this->speech_characters_per_second_);
+  this->next_speech_at_ = now + duration;
+  this->last_speech_ = speech.message;
+
+  CONNECTED_BEDROOM_PROFILE(PHASE_HA_SERVICE);
+  this->call_homeassistant_service("script.emettre_un_message",
+                                   {{"volume", "1.0"},
+                                    {"message", speech.message},
+                                    {"enceinte", "media_player.reveil_google_cast_de_la_chambre_de_louis"}});
+}
+
+/// @brief Envoie une longue trame (un message par exemple) à l'Arduino Mega. Si l'envoi par morceaux est activé, la
+/// trame est découpée en morceaux `7KKNN...` (morceau `KK` sur `NN`) envoyés depuis `loop()` au rythme de la liaison
+/// et des crédits accordés par l'Arduino Mega (`307CC`), pour ne jamais bloquer la boucle principale. Les autres
+/// trames peuvent être envoyées entre deux morceaux.
+/// @param frame La trame, sans le retour à la ligne final.
+void ConnectedBedroom::send_bulk_frame(const std::string &frame) {
+  if (this->chunk_size_ == 0 || frame.size() <= this->chunk_size_) {
+    this->send_frame(frame);
+    return;
+  }
+
+  if (this->bulk_frames_.size() >= BULK_QUEUE_SIZE) {
+    ESP_LOGW(TAG, "Bulk queue full, dropping frame '%s'.", this->bulk_frames_.back().c_str());
+    this->bulk_frames_.pop_back();
+  }
+
+  size_t max_size = size_t(this->chunk_size_) * MAX_CHUNKS;
+  if (frame.size() > max_size)
+    ESP_LOGW(TAG, "Frame too long for chunked transmit, truncated to %u bytes.", unsigned(max_size));
+
+  if (this->bulk_frames_.empty()) {
+    this->chunk_index_ = 0;
+    this->last_chunk_credit_ = millis();
+  }
+  this->bulk_frames_.push_back(frame.substr(0, max_size));
+}
+
+/// @brief Configure l'envoi par morceaux des longues trames.
+/// @param chunk_size Le nombre d'octets de données par morceau (limité pour que chaque morceau tienne dans le tampon de
+/// réception de l'Arduino Mega).
+/// @param initial_credit Le nombre de morceaux envoyés avant le premier crédit de l'Arduino Mega.
+/// @param credit_timeout Le délai sans crédit après lequel un morceau est tout de même envoyé.
+void ConnectedBedroom::set_chunked_transmit(uint8_t chunk_size, uint8_t initial_credit, uint32_t credit_timeout) {
+  this->chunk_size_ = std::min(chunk_size, protocol::MAX_CHUNK_PAYLOAD);
+  this->initial_chunk_credit_ = initial_credit;
+  this->chunk_credit_ = initial_credit;
+  this->chunk_credit_timeout_ = credit_timeout;
+}
+
+/// @brief Envoie le morceau suivant de la première longue trame en attente, si la liaison et le crédit le permettent.
+void ConnectedBedroom::process_bulk_frames_() {
+  uint32_t now = millis();
+  if (int32_t(now - this->next_chunk_at_) < 0)
+    return;
+
+  if (this->chunk_credit_ == 0) {
+    if (now - this->last_chunk_credit_ < this->chunk_credit_timeout_)
+      return;
+
+    // Sans crédit depuis trop longtemps : la trame de crédit a probablement été perdue.
+    ESP_LOGD(TAG, "No chunk credit from Arduino, sending next chunk anyway.");
+    this->chunk_credit_ = 1;
+    this->last_chunk_credit_ = now;
+  }
+
+  const std::string &frame = this->bulk_frames_.front();
+  uint8_t count = (frame.size() + this->chunk_size_ - 1) / this->chunk_size_;
+  std::string chunk = protocol::Chunk::encode(this->chunk_index_, count) +
+                      frame.substr(size_t(this->chunk_index_) * this->chunk_size_, this->chunk_size_);
+  this->send_frame(chunk);
+  this->chunk_credit_--;
+
+  // Le morceau suivant attend que celui-ci soit sorti de la FIFO matérielle, pour que l'écriture ne bloque pas.
+  this->next_chunk_at_ = now + (chunk.size() + 1) * 1000 / std::max<uint32_t>(this->get_link_byte_rate(), 1);
+
+  if (++this->chunk_index_ >= count) {
+    this->bulk_frames_.erase(this->bulk_frames_.begin());
+    this->chunk_index_ = 0;
+  }
+}
+
+/// @brief Met à jour le nombre de morceaux que l'Arduino Mega peut recevoir (place libre de son tampon).
+/// @param credit Le nombre de morceaux.
+void ConnectedBedroom::receive_chunk_credit_(uint8_t credit) {
+  this->chunk_credit_ = credit;
+  this->last_chunk_credit_ = millis();
+}
+
+/// @brief Envoie une trame critique à l'Arduino Mega. Si la livraison fiable est activée, la trame est suffixée d'un
+/// numéro de séquence (`*SS`) et renvoyée tant que l'Arduino Mega ne l'a pas acquittée (`304SS`). L'Arduino Mega
+/// acquitte aussi les doublons, sans les exécuter une seconde fois.
+/// @param frame La trame, sans le retour à la ligne final.
+/// @param traced_communication_id L'identifiant unique du périphérique dont la commande tracée est portée par la trame
+/// (`-1` si la trame ne porte pas de commande tracée).
+void ConnectedBedroom::send_critical_frame(const std::string &frame, int traced_communication_id) {
+  if (!this->reliable_commands_) {
+    this->send_frame(frame, traced_communication_id);
+    return;
+  }
+
+  // Recherche d'un emplacement libre dans la fenêtre (à défaut, la plus ancienne trame est abandonnée).
+  PendingFrame *pending = &this->pending_frames_[0];
+  for (uint8_t i = 0; i < RETRANSMIT_WINDOW_SIZE; i++) {
+    if (!this->pending_frames_[i].active) {
+      pending = &this->pending_frames_[i];
+      break;
+    }
+
+    if (int32_t(this->pending_frames_[i].sent_at - pending->sent_at) < 0)
+      pending = &this->pending_frames_[i];
+  }
+
+  if (pending->active)
+    ESP_LOGW(TAG, "Retransmit window full, dropping frame '%s'.", pending->frame.c_str());
+
+  pending->sequence = this->next_sequence_;
+  this->next_sequence_ = (this->next_sequence_ + 1) % 100;
+  pending->frame = frame + protocol::SEQUENCE_SEPARATOR;
+  protocol::append_digits(pending->frame, pending->sequence, protocol::SEQUENCE_WIDTH);
+  pending->attempts = 1;
+  pending->sent_at = millis();
+  pending->active = true;
+
+  this->send_frame(pending->frame, traced_communication_id);
+}
+
+/// @brief Libère la trame critique acquittée par l'Arduino Mega.
+/// @param sequence Le numéro de séquence acquitté.
+void ConnectedBedroom::acknowledge_frame_(uint8_t sequence) {
+  for (uint8_t i = 0; i < RETRANSMIT_WINDOW_SIZE; i++) {
+    PendingFrame &pending = this->pending_frames_[i];
+    if (pending.active && pending.sequence == sequence) {
+      pending.active = false;
+      pending.frame.clear();
+      return;
+    }
+  }
+}
+
+/// @brief Renvoie les trames critiques dont l'acquittement n'est pas arrivé à temps. Après trop de tentatives, la
+/// trame est abandonnée et une synchronisation est demandée.
+void ConnectedBedroom::process_retransmissions_() {
+  uint32_t now = millis();
+
+  for (uint8_t i = 0; i < RETRANSMIT_WINDOW_SIZE; i++) {
+    PendingFrame &pending = this->pending_frames_[i];
+    if (!pending.active || now - pending.sent_at < this->retransmit_timeout_)
+      continue;
+
+    if (pending.attempts > this->max_retransmits_) {
+      ESP_LOGW(TAG, "Frame '%s' was never acknowledged, requesting a synchronization.", pending.frame.c_str());
+      pending.active = false;
+      pending.frame.clear();
+      this->request_synchronization_();
+      continue;
+    }
+
+    ESP_LOGD(TAG, "Retransmitting frame '%s'.", pending.frame.c_str());
+    pending.attempts++;
+    pending.sent_at = now;
+    this->send_frame(pending.frame);
+  }
+}
+
+/// @brief Définit les musiques préenregistrées que l'Arduino Mega peut lancer avec leur index.
+/// @param music_presets Les URL, terminées par un caractère nul et placées à la suite en mémoire flash.
+/// @param music_presets_count Le nombre d'URL.
+void ConnectedBedroom::set_music_presets(const uint8_t *music_presets, uint16_t music_presets_count) {
+  this->music_presets_ = music_presets;
+  this->music_presets_count_ = music_presets_count;
+}
+
+/// @brief Lit l'URL d'une musique préenregistrée depuis la mémoire flash.
+/// @param index L'index de la musique dans `music_presets`.
+/// @param url L'URL lue.
+/// @return `false` si l'index ne correspond à aucune musique.
+bool ConnectedBedroom::get_music_preset_(int index, std::string &url) const {
+  if (this->music_presets_ == nullptr || index < 0 || index >= this->music_presets_count_)
+    return false;
+
+  const uint8_t *position = this->music_presets_;
+  for (int i = 0; i < index; i++) {
+    while (progmem_read_byte(position++) != 0) {
+    }
+  }
+
+  url.clear();
+  for (uint8_t character = progmem_read_byte(position); character != 0; character = progmem_read_byte(++position))
+    url.push_back(char(character));
+
+  return true;
+}
+
+/// @brief Définit la durée pendant laquelle les déplacements des curseurs d'un lance-missile sont regroupés.
+/// @param aim_coalescing_window La durée en millisecondes (`0` pour envoyer chaque déplacement immédiatement).
+void ConnectedBedroom::set_aim_coalescing_window(uint32_t aim_coalescing_window) {
+  this->aim_coalescing_window_ = aim_coalescing_window;
+}
+
+/// @brief Demande une visée à un lance-missile. Les demandes reçues pendant la durée de regroupement sont fusionnées
+/// et seule la dernière position de chaque axe est envoyée.
+/// @param communication_id L'identifiant unique du lance-missile.
+/// @param base La position de la base (`AIM_AXIS_UNCHANGED` pour la conserver).
+/// @param angle L'angle (`AIM_AXIS_UNCHANGED` pour le conserver).
+void ConnectedBedroom::aim_missile_launcher(int communication_id, int base, int angle) {
+  for (PendingAim &aim : this->pending_aims_) {
+    if (aim.communication_id != communication_id)
+      continue;
+
+    if (base != AIM_AXIS_UNCHANGED)
+      aim.base = base;
+    if (angle != AIM_AXIS_UNCHANGED)
+      aim.angle = angle;
+    return;
+  }
+
+  PendingAim aim{communication_id, base, angle, millis()};
+  if (this->aim_coalescing_window_ == 0) {
+    this->send_aim_(aim);
+    return;
+  }
+
+  this->pending_aims_.push_back(aim);
+}
+
+/// @brief Envoie immédiatement la visée en attente d'un lance-missile (avant un tir).
+/// @param communication_id L'identifiant unique du lance-missile.
+void ConnectedBedroom::flush_missile_launcher_aim(int communication_id) {
+  for (auto it = this->pending_aims_.begin(); it != this->pending_aims_.end(); it++) {
+    if (it->communication_id == communication_id) {
+      this->send_aim_(*it);
+      this->pending_aims_.erase(it);
+      return;
+    }
+  }
+}
+
+/// @brief Envoie les visées dont la durée de regroupement est écoulée.
+void ConnectedBedroom::process_aims_() {
+  uint32_t now = millis();
+
+  for (auto it = this->pending_aims_.begin(); it != this->pending_aims_.end();) {
+    if (now - it->requested_at < this->aim_coalescing_window_) {
+      it++;
+      continue;
+    }
+
+    this->send_aim_(*it);
+    it = this->pending_aims_.erase(it);
+  }
+}
+
+/// @brief Envoie une visée à l'Arduino Mega (`0II025BBBAAA`), qui déplace les deux axes ensemble et répond par la
+/// position finale (`1II035BBBAAA`).
+/// @param aim La visée.
+void ConnectedBedroom::send_aim_(const PendingAim &aim) {
+  this->send_frame(protocol::OrderMissileLauncherAim::encode(aim.communication_id, aim.base, aim.angle),
+                   aim.communication_id);
+}
+
+/// @brief Met en attente la publication d'une mise à jour reçue pendant la lecture des trames, en remplaçant la
+/// précédente mise à jour de la même entité. En dehors de la lecture (ou si l'attente est pleine), la mise à jour est
+/// publiée directement.
+/// @param communication_id L'identifiant unique du périphérique.
+/// @param slot L'emplacement de l'entité dans le périphérique.
+/// @param type Le type de l'entité.
+/// @param entity L'entité.
+/// @param value La valeur à publier.
+void ConnectedBedroom::stage_update_(int communication_id, uint8_t slot, StagedEntityTypes type, EntityBase *entity,
+                                     float value) {
+  StagedUpdate update{communication_id, slot, type, entity, value};
+
+  if (this->staging_updates_) {
+    for (uint8_t i = 0; i < this->staged_updates_count_; i++) {
+      if (this->staged_updates_[i].communication_id == communication_id && this->staged_updates_[i].slot == slot) {
+        this->staged_updates_[i] = update;
+        return;
+      }
+    }
+
+    if (this->staged_updates_count_ < MAX_STAGED_UPDATES) {
+      this->staged_updates_[this->staged_updates_count_++] = update;
+      return;
+    }
+  }
+
+  this->publish_update_(update);
+}
+
+/// @brief Publie les mises à jour en attente, dans l'ordre de leur première réception.
+void ConnectedBedroom::publish_staged_updates_() {
+  for (uint8_t i = 0; i < this->staged_updates_count_; i++)
+    this->publish_update_(this->staged_updates_[i]);
+
+  this->staged_updates_count_ = 0;
+}
+
+/// @brief Publie une mise à jour d'une entité.
+/// @param update La mise à jour.
+void ConnectedBedroom::publish_update_(const StagedUpdate &update) {
+  CONNECTED_BEDROOM_PROFILE(PHASE_PUBLISH);
+
+  switch (update.type) {
+    case STAGED_SWITCH:
+      static_cast<switch_::Switch *>(update.entity)->publish_state(update.value != 0.0f);
+      break;
+
+    case STAGED_BINARY_SENSOR:
+      static_cast<binary_sensor::BinarySensor *>(update.entity)->publish_state(update.value != 0.0f);
+      break;
+
+    case STAGED_SENSOR:
+      static_cast<sensor::Sensor *>(update.entity)->publish_state(update.value);
+      break;
+
+    case STAGED_NUMBER:
+      static_cast<number::Number *>(update.entity)->publish_state(update.value);
+      break;
+
+    case STAGED_ALARM:
+      static_cast<alarm_control_panel::AlarmControlPanel *>(update.entity)
+          ->publish_state(alarm_control_panel::AlarmControlPanelState(update.value));
+      break;
+  }
+}
+
+/// @brief Commence le traçage d'une commande, à son entrée dans le composant.
+/// @param communication_id L'identifiant unique du périphérique commandé.
+/// @param type Le type du périphérique commandé.
+void ConnectedBedroom::trace_command_start(int communication_id, TracedDeviceTypes type) {
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+  // Une commande plus récente pour le même périphérique remplace la précédente, sinon la plus ancienne est remplacée.
+  CommandTrace *trace = &this->command_traces_[0];
+  for (uint8_t i = 0; i < MAX_TRACED_COMMANDS; i++) {
+    CommandTrace &candidate = this->command_traces_[i];
+    if (!candidate.active || candidate.communication_id == communication_id) {
+      trace = &candidate;
+      break;
+    }
+
+    if (int32_t(candidate.started_at - trace->started_at) < 0)
+      trace = &candidate;
+  }
+
+  trace->communication_id = communication_id;
+  trace->type = type;
+  trace->started_at = micros();
+  trace->written = false;
+  trace->active = true;
+#endif
+}
+
+/// @brief Enregistre l'instant où le dernier octet de la trame d'une commande tracée a été transmis à l'UART.
+/// @param communication_id L'identifiant unique du périphérique commandé.
+void ConnectedBedroom::trace_command_written_(int communication_id) {
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+  uint32_t now = micros();
+
+  for (uint8_t i = 0; i < MAX_TRACED_COMMANDS; i++) {
+    CommandTrace &trace = this->command_traces_[i];
+    if (!trace.active || trace.written || trace.communication_id != communication_id)
+      continue;
+
+    trace.written = true;
+    trace.written_at = now;
+    this->latency_histograms_[trace.type].write[getLatencyBucket(now - trace.started_at)]++;
+  }
+#endif
+}
+
+/// @brief Termine le traçage d'une commande, à la réception de la mise à jour de l'état par l'Arduino Mega.
+/// @param communication_id L'identifiant unique du périphérique mis à jour.
+void ConnectedBedroom::trace_command_confirmed_(int communication_id) {
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+  for (uint8_t i = 0; i < MAX_TRACED_COMMANDS; i++) {
+    CommandTrace &trace = this->command_traces_[i];
+    if (!trace.active || !trace.written || trace.communication_id != communication_id)
+      continue;
+
+    trace.active = false;
+    this->latency_histograms_[trace.type].confirm[getLatencyBucket(micros() - trace.written_at)]++;
   }
+#endif
 }
 
-/// @brief Ajoute un bouton de tir d'un missile d'un lance-missile à la liste.
-/// @param communication_id L'identifiant unique de l'alarme, utilisé dans la communication avec l'Arduino méga.
-/// @param button L'objet du bouton.
-void ConnectedBedroom::add_alarm_missile_launcher_launch_button(int communication_id, button::Button *button) {
-  auto it =
-      std::find_if(alarms_.begin(), alarms_.end(),
-                   [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
-                                                       number::Number *, button::Button *, sensor::Sensor *> &element) {
-                     return std::get<0>(element) == communication_id;
-                   });
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+/// @brief Affiche les histogrammes de latence des commandes et les envoie à Home Assistant sous forme d'événements.
+void ConnectedBedroom::dump_command_latency_() {
+  std::string bounds;
+  for (uint8_t bucket = 0; bucket < LATENCY_BUCKETS_COUNT - 1; bucket++)
+    bounds += to_string(LATENCY_BUCKET_BOUNDS[bucket]) + ",";
+  bounds += "inf";
+  ESP_LOGI(TAG, "Command latency bucket bounds (us): %s", bounds.c_str());
+
+  for (uint8_t type = 0; type < TRACED_DEVICE_TYPES_COUNT; type++) {
+    std::string write;
+    std::string confirm;
+    for (uint8_t bucket = 0; bucket < LATENCY_BUCKETS_COUNT; bucket++) {
+      if (bucket > 0) {
+        write += ",";
+        confirm += ",";
+      }
+      write += to_string(this->latency_histograms_[type].write[bucket]);
+      confirm += to_string(this->latency_histograms_[type].confirm[bucket]);
+    }
 
-  if (it != alarms_.end()) {
-    std::get<4>(*it) = button;
-  } else {
-    this->alarms_.push_back(std::make_tuple(communication_id, nullptr, nullptr, nullptr, button, nullptr));
+    ESP_LOGI(TAG, "  %s: write [%s], confirm [%s]", TRACED_DEVICE_TYPE_NAMES[type], write.c_str(), confirm.c_str());
+    this->fire_homeassistant_event("esphome.connected_bedroom_command_latency",
+                                   {{"type", TRACED_DEVICE_TYPE_NAMES[type]},
+                                    {"bounds", bounds},
+                                    {"write", write},
+                                    {"confirm", confirm}});
   }
 }
 
-/// @brief Ajoute un capteur de missiles chargés d'un lance-missile à la liste.
-/// @param communication_id L'identifiant unique de l'alarme, utilisé dans la communication avec l'Arduino méga.
-/// @param sensor L'objet du capteur.
-void ConnectedBedroom::add_alarm_missile_launcher_available_missiles_sensor(int communication_id,
-                                                                            sensor::Sensor *sensor) {
-  auto it =
-      std::find_if(alarms_.begin(), alarms_.end(),
-                   [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
-                                                       number::Number *, button::Button *, sensor::Sensor *> &element) {
-                     return std::get<0>(element) == communication_id;
-                   });
+/// @brief Réinitialise les histogrammes de latence des commandes.
+void ConnectedBedroom::reset_command_latency_() {
+  for (uint8_t type = 0; type < TRACED_DEVICE_TYPES_COUNT; type++)
+    this->latency_histograms_[type] = LatencyHistogram{};
 
-  if (it != alarms_.end()) {
-    std::get<5>(*it) = sensor;
-  } else {
-    this->alarms_.push_back(std::make_tuple(communication_id, nullptr, nullptr, nullptr, nullptr, sensor));
+  for (uint8_t i = 0; i < MAX_TRACED_COMMANDS; i++)
+    this->command_traces_[i].active = false;
+}
+#endif
+
+/// @brief Compte un appel d'une fonction de rappel de Home Assistant (sans effet si les services de test d'endurance
+/// ne sont pas compilés).
+void ConnectedBedroom::count_ha_callback_() {
+#ifdef USE_CONNECTED_BEDROOM_SOAK_TEST
+  this->link_statistics_.ha_callbacks++;
+#endif
+}
+
+#ifdef USE_CONNECTED_BEDROOM_SOAK_TEST
+/// @brief Affiche les compteurs du trafic de la liaison (analysés par l'outil `tools/ha_soak_test.py`).
+void ConnectedBedroom::dump_link_statistics_() {
+  ESP_LOGI(TAG, "link statistics: uptime=%u rx_frames=%u tx_frames=%u tx_bytes=%u ha_callbacks=%u", millis(),
+           this->link_statistics_.rx_frames, this->link_statistics_.tx_frames, this->link_statistics_.tx_bytes,
+           this->link_statistics_.ha_callbacks);
+}
+
+/// @brief Réinitialise les compteurs du trafic de la liaison.
+void ConnectedBedroom::reset_link_statistics_() { this->link_statistics_ = {}; }
+
+/// @brief Traite une trame comme si elle avait été reçue de l'Arduino Mega (le message en cours de réception est
+/// conservé).
+/// @param frame La trame, sans le retour à la ligne final.
+void ConnectedBedroom::inject_frame_(std::string frame) {
+  std::vector<uint8_t> partial_message;
+  partial_message.swap(this->receivedMessage_);
+
+  this->receivedMessage_.assign(frame.begin(), frame.end());
+  this->process_message_();
+
+  this->receivedMessage_.swap(partial_message);
+}
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_RECORDER
+/// @brief Définit le nombre d'enregistrements conservés par l'enregistreur du trafic UART.
+/// @param traffic_recorder_size Le nombre d'enregistrements.
+void ConnectedBedroom::set_traffic_recorder_size(uint16_t traffic_recorder_size) {
+  this->traffic_recorder_size_ = traffic_recorder_size;
+}
+
+/// @brief Enregistre des octets échangés avec l'Arduino Mega. Les plus anciens enregistrements sont remplacés lorsque
+/// le tampon est plein.
+/// @param direction Le sens des octets.
+/// @param data Les octets.
+/// @param length Le nombre d'octets.
+void ConnectedBedroom::record_traffic_(TrafficDirections direction, const uint8_t *data, size_t length) {
+  if (this->traffic_records_.empty())
+    return;
+
+  uint32_t now = millis();
+  uint16_t size = this->traffic_records_.size();
+
+  for (size_t i = 0; i < length; i++) {
+    TrafficRecord *record = nullptr;
+    if (this->traffic_count_ > 0) {
+      record = &this->traffic_records_[(this->traffic_head_ + this->traffic_count_ - 1) % size];
+      if (record->direction != direction || record->length >= TRAFFIC_RECORD_DATA_SIZE || record->timestamp != now)
+        record = nullptr;
+    }
+
+    if (record == nullptr) {
+      if (this->traffic_count_ < size) {
+        record = &this->traffic_records_[(this->traffic_head_ + this->traffic_count_) % size];
+        this->traffic_count_++;
+      } else {
+        record = &this->traffic_records_[this->traffic_head_];
+        this->traffic_head_ = (this->traffic_head_ + 1) % size;
+      }
+
+      record->timestamp = now;
+      record->direction = direction;
+      record->length = 0;
+    }
+
+    record->data[record->length++] = data[i];
   }
 }
 
-/// @brief Ajoute une télévision à la liste des périphériques connectés.
-/// @param communication_id L'identifiant unique utilisée dans la communication avec l'Arduino méga.
-/// @param television L'objet de la télévision.
-void ConnectedBedroom::add_television(int communication_id, ConnectedBedroomTelevision *television) {
-  this->televisions_.push_back(std::make_pair(communication_id, television));
+/// @brief Affiche le trafic enregistré, encodé en hexadécimal. Chaque enregistrement est composé du sens (1 octet), de
+/// l'instant en millisecondes (4 octets, petit-boutiste), de la longueur (1 octet) et des octets échangés. Le flux est
+/// précédé de l'en-tête `CBR1` ; l'outil `tools/traffic_replay.py` le reconstitue à partir des journaux.
+void ConnectedBedroom::dump_traffic_() {
+  ESP_LOGI(TAG, "traffic begin %u", this->traffic_count_);
+
+  std::vector<uint8_t> chunk = {'C', 'B', 'R', '1'};
+  uint16_t size = this->traffic_records_.size();
+
+  for (uint16_t i = 0; i < this->traffic_count_; i++) {
+    const TrafficRecord &record = this->traffic_records_[(this->traffic_head_ + i) % size];
+    chunk.push_back(record.direction);
+    for (uint8_t shift = 0; shift < 32; shift += 8)
+      chunk.push_back((record.timestamp >> shift) & 0xFF);
+    chunk.push_back(record.length);
+    chunk.insert(chunk.end(), record.data, record.data + record.length);
+
+    if (chunk.size() >= 48) {
+      ESP_LOGI(TAG, "traffic %s", format_hex(chunk).c_str());
+      chunk.clear();
+    }
+  }
+
+  if (!chunk.empty())
+    ESP_LOGI(TAG, "traffic %s", format_hex(chunk).c_str());
+
+  ESP_LOGI(TAG, "traffic end");
 }
 
-/// @brief Ajoute un périphérique connecté depuis Home Assistant à la liste des périphériques connectés.
-/// @param communication_id L'identifiant unique utilisée dans la communication avec l'Arduino méga.
-/// @param entity_id L'identifiant de Home Assistant, du périphérique.
-/// @param type Le type du périphérique.
-void ConnectedBedroom::add_connected_device(int communication_id, std::string entity_id, ConnectedDeviceTypes type) {
-  this->connected_lights_.push_back(std::make_tuple(communication_id, entity_id, type));
+/// @brief Efface le trafic enregistré.
+void ConnectedBedroom::clear_traffic_() {
+  this->traffic_head_ = 0;
+  this->traffic_count_ = 0;
 }
+#endif
 
-/// @brief Ajoute un ruban de DEL RVB à la liste des périphériques connectés.
-/// @param communication_id L'identifiant unique utilisée dans la communication avec l'Arduino méga.
-/// @param light L'objet du ruban de DEL RVB.
-void ConnectedBedroom::add_RGB_LED_strip(int communication_id, ConnectedBedroomRGBLEDStrip *light) {
-  this->RGB_LED_strips_.push_back(std::make_pair(communication_id, light));
+#ifdef USE_CONNECTED_BEDROOM_PROFILER
+/// @brief Affiche les mesures du profileur de la boucle.
+void ConnectedBedroom::dump_loop_profile_() { this->loop_profiler_.dump(); }
+
+/// @brief Réinitialise les mesures du profileur de la boucle.
+void ConnectedBedroom::reset_loop_profile_() { this->loop_profiler_.reset(); }
+#endif
+
+/// @brief Enregistre les derniers états connus dans la mémoire persistante.
+void ConnectedBedroom::save_states_() {
+  this->states_preference_.save(&this->persisted_states_);
+  this->states_dirty_ = false;
+  this->last_states_save_ = millis();
 }
 
 /// @brief Méthode permettant de récupérer un objet de capteur analogique à partir de son identifiant unique de
@@ -809,6 +2466,8 @@ void ConnectedBedroom::add_RGB_LED_strip(int communication_id, ConnectedBedroomR
 /// @return Un pointeur vers le périphérique correspondant au `communication_id` renseigné, ou `nullptr` si aucun
 /// périphérique n'a été trouvé.
 sensor::Sensor *ConnectedBedroom::get_analog_sensor_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it = std::find_if(analog_sensors_.begin(), analog_sensors_.end(),
                          [communication_id](const std::pair<int, sensor::Sensor *> &element) {
                            return element.first == communication_id;
@@ -821,12 +2480,34 @@ sensor::Sensor *ConnectedBedroom::get_analog_sensor_from_communication_id_(int c
   }
 }
 
+/// @brief Méthode permettant de récupérer un capteur à plusieurs valeurs à partir de son identifiant unique de
+/// communication.
+/// @param communication_id L'identifiant unique du périphérique à récupérer.
+/// @return Un pointeur vers le périphérique correspondant au `communication_id` renseigné, ou `nullptr` si aucun
+/// périphérique n'a été trouvé.
+const MultiValueSensor *ConnectedBedroom::get_multi_value_sensor_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
+  auto it = std::find_if(multi_value_sensors_.begin(), multi_value_sensors_.end(),
+                         [communication_id](const MultiValueSensor &element) {
+                           return element.communication_id == communication_id;
+                         });
+
+  if (it != multi_value_sensors_.end()) {
+    return &*it;
+  } else {
+    return nullptr;
+  }
+}
+
 /// @brief Méthode permettant de récupérer un objet de capteur binaire à partir de son identifiant unique de
 /// communication.
 /// @param communication_id L'identifiant unique du périphérique à récupérer.
 /// @return Un pointeur vers le périphérique correspondant au `communication_id` renseigné, ou `nullptr` si aucun
 /// périphérique n'a été trouvé.
 binary_sensor::BinarySensor *ConnectedBedroom::get_binary_sensor_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it = std::find_if(binary_sensors_.begin(), binary_sensors_.end(),
                          [communication_id](const std::pair<int, binary_sensor::BinarySensor *> &element) {
                            return element.first == communication_id;
@@ -844,6 +2525,8 @@ binary_sensor::BinarySensor *ConnectedBedroom::get_binary_sensor_from_communicat
 /// @return Un pointeur vers le périphérique correspondant au `communication_id` renseigné, ou `nullptr` si aucun
 /// périphérique n'a été trouvé.
 switch_::Switch *ConnectedBedroom::get_switch_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it = std::find_if(switches_.begin(), switches_.end(),
                          [communication_id](const std::pair<int, switch_::Switch *> &element) {
                            return element.first == communication_id;
@@ -861,6 +2544,8 @@ switch_::Switch *ConnectedBedroom::get_switch_from_communication_id_(int communi
 /// @return Un pointeur vers le périphérique correspondant au `communication_id` renseigné, ou `nullptr` si aucun
 /// périphérique n'a été trouvé.
 alarm_control_panel::AlarmControlPanel *ConnectedBedroom::get_alarm_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it =
       std::find_if(alarms_.begin(), alarms_.end(),
                    [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
@@ -881,6 +2566,8 @@ alarm_control_panel::AlarmControlPanel *ConnectedBedroom::get_alarm_from_communi
 /// @return Un pointeur vers l'entité correspondant au `communication_id` renseigné, ou `nullptr` si aucune entité n'a
 /// été trouvé.
 number::Number *ConnectedBedroom::get_missile_launcher_base_number_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it =
       std::find_if(alarms_.begin(), alarms_.end(),
                    [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
@@ -901,6 +2588,8 @@ number::Number *ConnectedBedroom::get_missile_launcher_base_number_from_communic
 /// @return Un pointeur vers l'entité correspondant au `communication_id` renseigné, ou `nullptr` si aucune entité n'a
 /// été trouvé.
 number::Number *ConnectedBedroom::get_missile_launcher_angle_number_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it =
       std::find_if(alarms_.begin(), alarms_.end(),
                    [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
@@ -922,6 +2611,8 @@ number::Number *ConnectedBedroom::get_missile_launcher_angle_number_from_communi
 /// été trouvé.
 button::Button *ConnectedBedroom::get_missile_launcher_launch_button_from_communication_id_(
     int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it =
       std::find_if(alarms_.begin(), alarms_.end(),
                    [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
@@ -943,6 +2634,8 @@ button::Button *ConnectedBedroom::get_missile_launcher_launch_button_from_commun
 /// été trouvé.
 sensor::Sensor *ConnectedBedroom::get_missile_launcher_available_missiles_sensor_from_communication_id_(
     int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it =
       std::find_if(alarms_.begin(), alarms_.end(),
                    [communication_id](const std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *,
@@ -962,6 +2655,8 @@ sensor::Sensor *ConnectedBedroom::get_missile_launcher_available_missiles_sensor
 /// @return Un pointeur vers le périphérique correspondant au `communication_id` renseigné, ou `nullptr` si aucun
 /// périphérique n'a été trouvé.
 ConnectedBedroomTelevision *ConnectedBedroom::get_television_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it = std::find_if(televisions_.begin(), televisions_.end(),
                          [communication_id](const std::pair<int, ConnectedBedroomTelevision *> &element) {
                            return element.first == communication_id;
@@ -980,6 +2675,8 @@ ConnectedBedroomTelevision *ConnectedBedroom::get_television_from_communication_
 /// @return Un pointeur vers le périphérique correspondant au `communication_id` renseigné, ou `nullptr` si aucun
 /// périphérique n'a été trouvé.
 ConnectedBedroomRGBLEDStrip *ConnectedBedroom::get_RGB_LED_strip_from_communication_id(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it = std::find_if(RGB_LED_strips_.begin(), RGB_LED_strips_.end(),
                          [communication_id](const std::pair<int, ConnectedBedroomRGBLEDStrip *> &element) {
                            return element.first == communication_id;
@@ -998,6 +2695,8 @@ ConnectedBedroomRGBLEDStrip *ConnectedBedroom::get_RGB_LED_strip_from_communicat
 /// @return Un pointeur vers le périphérique correspondant au `communication_id` renseigné, ou `nullptr` si aucun
 /// périphérique n'a été trouvé.
 std::string ConnectedBedroom::get_connected_device_from_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it = std::find_if(connected_lights_.begin(), connected_lights_.end(),
                          [communication_id](const std::tuple<int, std::string, ConnectedDeviceTypes> &element) {
                            return std::get<0>(element) == communication_id;
@@ -1015,6 +2714,8 @@ std::string ConnectedBedroom::get_connected_device_from_communication_id_(int co
 /// @return L'identifiant unique dans la communication avec l'Arduino Mega. Retourne `-1` si aucun périphérique n'a été
 /// trouvé.
 int ConnectedBedroom::get_communication_id_from_connected_light_entity_id_(std::string entity_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it = std::find_if(connected_lights_.begin(), connected_lights_.end(),
                          [entity_id](const std::tuple<int, std::string, ConnectedDeviceTypes> &element) {
                            return std::get<1>(element) == entity_id;
@@ -1032,6 +2733,8 @@ int ConnectedBedroom::get_communication_id_from_connected_light_entity_id_(std::
 /// @param communication_id L'identifiant unique.
 /// @return Le type du périphérique connecté (renvoie `BINARY_CONNECTED_DEVICE` par défaut).
 ConnectedDeviceTypes ConnectedBedroom::get_type_from_connected_light_communication_id_(int communication_id) const {
+  CONNECTED_BEDROOM_PROFILE(PHASE_LOOKUP);
+
   auto it = std::find_if(connected_lights_.begin(), connected_lights_.end(),
                          [communication_id](const std::tuple<int, std::string, ConnectedDeviceTypes> &element) {
                            return std::get<0>(element) == communication_id;
@@ -1044,6 +2747,90 @@ ConnectedDeviceTypes ConnectedBedroom::get_type_from_connected_light_communicati
   }
 }
 
+#ifdef USE_CONNECTED_BEDROOM_PROFILER
+/// @brief Début de la mesure d'une phase.
+void LoopProfiler::enter() {
+  if (this->depth_ >= PROFILER_MAX_DEPTH) {
+    this->depth_++;
+    return;
+  }
+
+  this->child_cycles_[this->depth_] = 0;
+  this->started_at_[this->depth_] = arch_get_cpu_cycle_count();
+  this->depth_++;
+}
+
+/// @brief Fin de la mesure d'une phase : seul le temps qui n'a pas été attribué à une phase imbriquée est compté.
+/// @param phase La phase mesurée.
+void LoopProfiler::exit(LoopPhases phase) {
+  uint32_t now = arch_get_cpu_cycle_count();
+
+  this->depth_--;
+  if (this->depth_ >= PROFILER_MAX_DEPTH)
+    return;
+
+  uint32_t total = now - this->started_at_[this->depth_];
+  uint32_t cycles = total - this->child_cycles_[this->depth_];
+  if (this->depth_ > 0)
+    this->child_cycles_[this->depth_ - 1] += total;
+
+  PhaseProfile &profile = this->profiles_[phase];
+  profile.count++;
+  profile.total_cycles += cycles;
+  if (cycles > profile.max_cycles) {
+    profile.max_cycles = cycles;
+    profile.max_at = millis();
+  }
+
+  uint8_t bucket = cycles == 0 ? 0 : 31 - __builtin_clz(cycles);
+  if (bucket >= PROFILER_BUCKETS_COUNT)
+    bucket = PROFILER_BUCKETS_COUNT - 1;
+  profile.buckets[bucket]++;
+}
+
+/// @brief Affiche les mesures de chaque phase.
+void LoopProfiler::dump() const {
+  float cycles_per_us = float(arch_get_cpu_freq_hz()) / 1000000.0f;
+
+  ESP_LOGI(TAG, "Loop profile (%.0f cycles/us):", cycles_per_us);
+  for (uint8_t phase = 0; phase < LOOP_PHASES_COUNT; phase++) {
+    const PhaseProfile &profile = this->profiles_[phase];
+    if (profile.count == 0)
+      continue;
+
+    std::string buckets;
+    for (uint8_t bucket = 0; bucket < PROFILER_BUCKETS_COUNT; bucket++) {
+      if (profile.buckets[bucket] == 0)
+        continue;
+      if (!buckets.empty())
+        buckets += " ";
+      buckets += "2^" + to_string(bucket) + ":" + to_string(profile.buckets[bucket]);
+    }
+
+    ESP_LOGI(TAG, "  %s: count=%u mean=%.1fus max=%.1fus (at %u ms)", LOOP_PHASE_NAMES[phase], profile.count,
+             float(profile.total_cycles) / float(profile.count) / cycles_per_us,
+             float(profile.max_cycles) / cycles_per_us, profile.max_at);
+    ESP_LOGI(TAG, "    cycles histogram: %s", buckets.c_str());
+  }
+}
+
+/// @brief Réinitialise les mesures de chaque phase.
+void LoopProfiler::reset() {
+  for (uint8_t phase = 0; phase < LOOP_PHASES_COUNT; phase++)
+    this->profiles_[phase] = PhaseProfile{};
+}
+
+/// @brief Constructeur de la mesure d'une phase.
+/// @param profiler Le profileur.
+/// @param phase La phase mesurée.
+LoopProfilerScope::LoopProfilerScope(LoopProfiler *profiler, LoopPhases phase) : profiler_(profiler), phase_(phase) {
+  this->profiler_->enter();
+}
+
+/// @brief Destructeur de la mesure d'une phase.
+LoopProfilerScope::~LoopProfilerScope() { this->profiler_->exit(this->phase_); }
+#endif
+
 /// @brief Méthode permettant de définit l'identifiant unique utilisé dans la communication avec l'Arduino Mega.
 /// @param communication_id L'identifant unique.
 void ConnectedBedroomDevice::set_communication_id(int communication_id) { this->communication_id_ = communication_id; }
@@ -1065,12 +2852,8 @@ void ConnectedBedroomSwitch::register_device() { this->parent_->add_switch(this-
 /// @brief Envoie une requête à l'Arduino Mega pour modifier l'état d'un périphérique.
 /// @param state L'état à définir.
 void ConnectedBedroomSwitch::write_state(bool state) {
-  this->parent_->write('0');
-  this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-  this->parent_->write('0');
-  this->parent_->write('0');
-  this->parent_->write(state ? '1' : '0');
-  this->parent_->write('\n');
+  this->parent_->trace_command_start(this->communication_id_, TRACED_SWITCH);
+  this->parent_->send_frame(protocol::OrderPower::encode(this->communication_id_, state), this->communication_id_);
 }
 
 /// @brief Méthode enregistrant le périphérique auprès de l'objet principal du composant externe.
@@ -1109,38 +2892,29 @@ void ConnectedBedroomAlarmControlPanel::control(const alarm_control_panel::Alarm
       return;
   }
 
-  this->parent_->write('0');
-  this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
+  std::string frame;
 
   if (call.get_state() == alarm_control_panel::ACP_STATE_ARMED_AWAY &&
-      this->current_state_ == alarm_control_panel::ACP_STATE_DISARMED) {
-    this->parent_->write('0');
-    this->parent_->write('0');
-    this->parent_->write('1');
-  }
+      this->current_state_ == alarm_control_panel::ACP_STATE_DISARMED)
+    frame = protocol::OrderPower::encode(this->communication_id_, true);
 
   else if (call.get_state() == alarm_control_panel::ACP_STATE_ARMED_AWAY &&
-           this->current_state_ == alarm_control_panel::ACP_STATE_TRIGGERED) {
-    this->parent_->write('0');
-    this->parent_->write('2');
-    this->parent_->write('0');
-  }
+           this->current_state_ == alarm_control_panel::ACP_STATE_TRIGGERED)
+    frame = protocol::OrderAlarm::encode(this->communication_id_, protocol::ALARM_RESET);
 
   else if (call.get_state() == alarm_control_panel::ACP_STATE_DISARMED &&
-           this->current_state_ != alarm_control_panel::ACP_STATE_DISARMED) {
-    this->parent_->write('0');
-    this->parent_->write('0');
-    this->parent_->write('0');
-  }
+           this->current_state_ != alarm_control_panel::ACP_STATE_DISARMED)
+    frame = protocol::OrderPower::encode(this->communication_id_, false);
 
   else if (call.get_state() == alarm_control_panel::ACP_STATE_PENDING &&
-           this->current_state_ != alarm_control_panel::ACP_STATE_TRIGGERED) {
-    this->parent_->write('0');
-    this->parent_->write('2');
-    this->parent_->write('1');
-  }
+           this->current_state_ != alarm_control_panel::ACP_STATE_TRIGGERED)
+    frame = protocol::OrderAlarm::encode(this->communication_id_, protocol::ALARM_TRIGGER);
+
+  else
+    return;
 
-  this->parent_->write('\n');
+  this->parent_->trace_command_start(this->communication_id_, TRACED_ALARM);
+  this->parent_->send_critical_frame(frame, this->communication_id_);
 }
 
 /// @brief Méthode enregistrant le périphérique auprès de l'objet principal du composant externe.
@@ -1151,13 +2925,8 @@ void ConnectedBedroomMissileLauncherBaseNumber::register_device() {
 /// @brief Méthode de contrôle de l'entité.
 /// @param value La valeur à définir.
 void ConnectedBedroomMissileLauncherBaseNumber::control(float value) {
-  this->parent_->write('0');
-  this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-  this->parent_->write('0');
-  this->parent_->write('2');
-  this->parent_->write('2');
-  this->parent_->write_str(addZeros(value, 3).c_str());
-  this->parent_->write('\n');
+  this->parent_->trace_command_start(this->communication_id_, TRACED_MISSILE_LAUNCHER);
+  this->parent_->aim_missile_launcher(this->communication_id_, value, AIM_AXIS_UNCHANGED);
 }
 
 /// @brief Méthode enregistrant le périphérique auprès de l'objet principal du composant externe.
@@ -1168,13 +2937,8 @@ void ConnectedBedroomMissileLauncherAngleNumber::register_device() {
 /// @brief Méthode de contrôle de l'entité.
 /// @param value La valeur à définir.
 void ConnectedBedroomMissileLauncherAngleNumber::control(float value) {
-  this->parent_->write('0');
-  this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-  this->parent_->write('0');
-  this->parent_->write('2');
-  this->parent_->write('3');
-  this->parent_->write_str(addZeros(value, 3).c_str());
-  this->parent_->write('\n');
+  this->parent_->trace_command_start(this->communication_id_, TRACED_MISSILE_LAUNCHER);
+  this->parent_->aim_missile_launcher(this->communication_id_, AIM_AXIS_UNCHANGED, value);
 }
 
 /// @brief Méthode enregistrant le périphérique auprès de l'objet principal du composant externe.
@@ -1184,12 +2948,10 @@ void ConnectedBedroomMissileLauncherLaunchButton::register_device() {
 
 /// @brief Méthode de contrôle de l'entité.
 void ConnectedBedroomMissileLauncherLaunchButton::press_action() {
-  this->parent_->write('0');
-  this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-  this->parent_->write('0');
-  this->parent_->write('2');
-  this->parent_->write('4');
-  this->parent_->write('\n');
+  this->parent_->trace_command_start(this->communication_id_, TRACED_MISSILE_LAUNCHER);
+  this->parent_->flush_missile_launcher_aim(this->communication_id_);
+  this->parent_->send_critical_frame(protocol::OrderMissileLaunch::encode(this->communication_id_),
+                                     this->communication_id_);
 }
 
 /// @brief Méthode permettant d'enregistrer l'objet auprès de la télévision.
@@ -1205,12 +2967,9 @@ void TelevisionState::register_component() { this->parent_->state = this; }
 /// @brief Envoie une requête à l'Arduino Mega pour modifier l'état d'un périphérique.
 /// @param state L'état à définir.
 void TelevisionState::write_state(bool state) {
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write_str(addZeros(this->parent_->communication_id_, 2).c_str());
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write(state ? '1' : '0');
-  this->parent_->parent_->write('\n');
+  this->parent_->parent_->trace_command_start(this->parent_->communication_id_, TRACED_TELEVISION);
+  this->parent_->parent_->send_critical_frame(protocol::OrderPower::encode(this->parent_->communication_id_, state),
+                                              this->parent_->communication_id_);
 }
 
 /// @brief Méthode permettant d'enregistrer l'objet auprès de la télévision.
@@ -1219,24 +2978,21 @@ void TelevisionMuted::register_component() { this->parent_->muted = this; }
 /// @brief Envoie une requête à l'Arduino Mega pour modifier l'état d'un périphérique.
 /// @param state L'état à définir.
 void TelevisionMuted::write_state(bool state) {
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write_str(addZeros(this->parent_->communication_id_, 2).c_str());
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write('3');
-  this->parent_->parent_->write(state ? '2' : '3');
-  this->parent_->parent_->write('\n');
+  this->parent_->parent_->trace_command_start(this->parent_->communication_id_, TRACED_TELEVISION);
+  this->parent_->parent_->send_frame(
+      protocol::OrderTelevision::encode(this->parent_->communication_id_,
+                                        state ? protocol::TELEVISION_MUTE : protocol::TELEVISION_UNMUTE),
+      this->parent_->communication_id_);
 }
 
 /// @brief Méthode permettant d'enregistrer l'objet auprès de la télévision.
 void TelevisionVolumeUp::register_component() { this->parent_->volume_up = this; }
 
 void TelevisionVolumeUp::press_action() {
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write_str(addZeros(this->parent_->communication_id_, 2).c_str());
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write('3');
-  this->parent_->parent_->write('1');
-  this->parent_->parent_->write('\n');
+  this->parent_->parent_->trace_command_start(this->parent_->communication_id_, TRACED_TELEVISION);
+  this->parent_->parent_->send_frame(
+      protocol::OrderTelevision::encode(this->parent_->communication_id_, protocol::TELEVISION_VOLUME_UP),
+      this->parent_->communication_id_);
 }
 
 /// @brief Méthode permettant d'enregistrer l'objet auprès de la télévision.
@@ -1244,12 +3000,21 @@ void TelevisionVolumeDown::register_component() { this->parent_->volume_down = t
 
 /// @brief Envoie la requête de contrôle à l'Arduino Mega.
 void TelevisionVolumeDown::press_action() {
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write_str(addZeros(this->parent_->communication_id_, 2).c_str());
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write('3');
-  this->parent_->parent_->write('0');
-  this->parent_->parent_->write('\n');
+  this->parent_->parent_->trace_command_start(this->parent_->communication_id_, TRACED_TELEVISION);
+  this->parent_->parent_->send_frame(
+      protocol::OrderTelevision::encode(this->parent_->communication_id_, protocol::TELEVISION_VOLUME_DOWN),
+      this->parent_->communication_id_);
+}
+
+/// @brief Méthode permettant d'enregistrer l'objet auprès de la télévision.
+void TelevisionVolume::register_component() { this->parent_->volume_number = this; }
+
+/// @brief Envoie le volume à atteindre à l'Arduino Mega (une seule trame, quel que soit l'écart avec le volume actuel).
+/// @param value Le volume à atteindre.
+void TelevisionVolume::control(float value) {
+  this->parent_->parent_->trace_command_start(this->parent_->communication_id_, TRACED_TELEVISION);
+  this->parent_->parent_->send_frame(protocol::OrderTelevisionVolume::encode(this->parent_->communication_id_, value),
+                                     this->parent_->communication_id_);
 }
 
 /// @brief Méthode enregistrant le périphérique auprès de l'objet principal du composant externe.
@@ -1272,117 +3037,469 @@ light::LightTraits ConnectedBedroomRGBLEDStrip::get_traits() {
 
 /// @brief Méthode permettant d'enregistrer l'entité d'état de la lumière auprès de l'objet.
 /// @param state Le pointeur vers l'objet d'état du ruban de DEL RVB.
-void ConnectedBedroomRGBLEDStrip::setup_state(light::LightState *state) { this->state = state; }
+void ConnectedBedroomRGBLEDStrip::setup_state(light::LightState *state) {
+  this->state = state;
+
+  // Association des modes de l'entité à ceux de l'Arduino Mega, une fois pour toutes.
+  const std::vector<light::LightEffect *> &effects = state->get_effects();
+  this->effects_.assign(effects.size() + 1, nullptr);
+  for (size_t i = 0; i < effects.size(); i++) {
+    this->effects_[i + 1] = ConnectedBedroomRGBLEDStripEffect::find(effects[i]);
+    if (this->effects_[i + 1] != nullptr)
+      this->effects_[i + 1]->set_strip(this);
+  }
+}
 
-/// @brief Envoie une requête à l'Arduino Mega pour modifier l'état d'un périphérique.
+/// @brief Envoie une requête à l'Arduino Mega pour modifier l'état d'un périphérique. Les trames identiques au dernier
+/// état envoyé ne sont pas renvoyées.
 /// @param state L'état à définir.
 void ConnectedBedroomRGBLEDStrip::write_state(light::LightState *state) {
-  if (this->block_next_write_) {
-    this->block_next_write_ = false;
+  bool power = this->state->remote_values.get_state();
+
+  ConnectedBedroomRGBLEDStripEffect *effect_instance = this->get_current_effect_();
+  RGBLEDStripEffects effect = effect_instance != nullptr ? effect_instance->get_effect() : RGB_LED_STRIP_NO_EFFECT;
+
+  uint8_t color[3];
+  this->get_output_color_(color);
+
+  // Trames à envoyer, dans l'ordre : alimentation, paramètres du mode (avant sa sélection, pour que l'Arduino Mega
+  // l'exécute directement avec), puis mode ou couleur.
+  std::string power_frame, parameters_frame, state_frame;
+
+  if (power != this->previous_state_)
+    power_frame = protocol::OrderPower::encode(this->communication_id_, power);
+
+  if (power || this->previous_state_) {
+    if (effect != RGB_LED_STRIP_NO_EFFECT) {
+      parameters_frame = this->get_effect_parameters_frame_(effect_instance);
+
+      if (!this->sent_state_known_ || effect != this->sent_effect_)
+        state_frame = protocol::OrderRGBLEDStripEffect::encode(this->communication_id_, effect);
+    }
+
+    else if (power && (!this->sent_state_known_ || this->sent_effect_ != RGB_LED_STRIP_NO_EFFECT ||
+                       memcmp(color, this->sent_color_, 3) != 0))
+      state_frame = protocol::OrderRGBLEDStripColor::encode(this->communication_id_, color[0], color[1], color[2]);
+  }
+
+  this->remember_sent_state_(power, effect, color);
+
+  if (power_frame.empty() && parameters_frame.empty() && state_frame.empty())
+    return;
+
+  // La transition en cours est remplacée par les trames envoyées.
+  this->transition_length_ = 0;
+
+  // La commande n'est écrite qu'avec le dernier octet de la dernière trame.
+  this->parent_->trace_command_start(this->communication_id_, TRACED_RGB_LED_STRIP);
+  if (!power_frame.empty())
+    this->parent_->send_frame(power_frame,
+                              parameters_frame.empty() && state_frame.empty() ? this->communication_id_ : -1);
+  if (!parameters_frame.empty())
+    this->parent_->send_frame(parameters_frame, state_frame.empty() ? this->communication_id_ : -1);
+  if (!state_frame.empty())
+    this->parent_->send_frame(state_frame, this->communication_id_);
+}
+
+/// @brief Retourne le mode de ce composant sélectionné dans l'entité.
+/// @return Le mode, ou `nullptr` si aucun mode de ce composant n'est sélectionné.
+ConnectedBedroomRGBLEDStripEffect *ConnectedBedroomRGBLEDStrip::get_current_effect_() const {
+  uint32_t effect_index = this->state->get_current_effect_index();
+  return effect_index < this->effects_.size() ? this->effects_[effect_index] : nullptr;
+}
+
+/// @brief Mémorise le dernier état envoyé à l'Arduino Mega (ou reçu de celui-ci).
+/// @param power L'état de l'alimentation.
+/// @param effect Le mode de l'Arduino Mega.
+/// @param color La couleur.
+void ConnectedBedroomRGBLEDStrip::remember_sent_state_(bool power, RGBLEDStripEffects effect, const uint8_t color[3]) {
+  this->previous_state_ = power;
+
+  // La couleur et le mode ne sont pas modifiés par l'extinction.
+  if (!power)
+    return;
+
+  this->sent_state_known_ = true;
+  this->sent_effect_ = effect;
+  if (effect == RGB_LED_STRIP_NO_EFFECT)
+    memcpy(this->sent_color_, color, 3);
+}
+
+/// @brief Calcule la couleur envoyée à l'Arduino Mega pour l'état actuel de l'entité.
+/// @param color La couleur.
+void ConnectedBedroomRGBLEDStrip::get_output_color_(uint8_t color[3]) const {
+  float r, g, b;
+  this->state->current_values_as_rgb(&r, &g, &b, false);
+  color[0] = uint8_t(r * 255.0f);
+  color[1] = uint8_t(g * 255.0f);
+  color[2] = uint8_t(b * 255.0f);
+}
+
+/// @brief Enregistre l'état de l'alimentation confirmé par l'Arduino Mega, déjà appliqué à l'entité. Si la couleur et
+/// le mode affichés par l'Arduino Mega sont encore inconnus, ceux de l'entité sont considérés comme confirmés : un
+/// allumage confirmé ne doit pas être suivi d'une trame de couleur ou de mode (les mises à jour suivantes de l'Arduino
+/// Mega les corrigeront).
+/// @param power L'état de l'alimentation.
+void ConnectedBedroomRGBLEDStrip::confirm_power(bool power) {
+  if (!power || this->sent_state_known_) {
+    this->previous_state_ = power;
     return;
   }
 
-  if (!this->previous_state_ && this->state->remote_values.get_state()) {
-    previous_state_ = true;
+  ConnectedBedroomRGBLEDStripEffect *effect = this->get_current_effect_();
+  uint8_t color[3];
+  this->get_output_color_(color);
+  this->remember_sent_state_(true, effect != nullptr ? effect->get_effect() : RGB_LED_STRIP_NO_EFFECT, color);
 
-    this->parent_->write('0');
-    this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-    this->parent_->write('0');
-    this->parent_->write('0');
-    this->parent_->write('1');
-    this->parent_->write('\n');
+  // Les paramètres du mode sont enregistrés comme envoyés, la trame est ignorée.
+  if (effect != nullptr)
+    this->get_effect_parameters_frame_(effect);
+}
+
+/// @brief Enregistre la couleur confirmée par l'Arduino Mega, déjà appliquée à l'entité : elle est relue telle que
+/// `write_state()` la calculera, pour que la comparaison ne dépende pas des corrections appliquées par l'entité.
+void ConnectedBedroomRGBLEDStrip::confirm_color() {
+  uint8_t color[3];
+  this->get_output_color_(color);
+  this->remember_sent_state_(true, RGB_LED_STRIP_NO_EFFECT, color);
+}
+
+/// @brief Enregistre le mode confirmé par l'Arduino Mega (la couleur enregistrée n'est pas modifiée).
+/// @param effect Le mode.
+void ConnectedBedroomRGBLEDStrip::confirm_effect(RGBLEDStripEffects effect) {
+  this->remember_sent_state_(true, effect, this->sent_color_);
+}
+
+/// @brief Retourne l'index du mode de l'entité correspondant à un mode de l'Arduino Mega.
+/// @param effect Le mode de l'Arduino Mega.
+/// @return L'index du mode de l'entité (`0` si aucun mode ne correspond).
+uint32_t ConnectedBedroomRGBLEDStrip::get_effect_index(RGBLEDStripEffects effect) const {
+  for (uint32_t i = 1; i < this->effects_.size(); i++) {
+    if (this->effects_[i] != nullptr && this->effects_[i]->get_effect() == effect)
+      return i;
   }
 
-  else if (this->previous_state_ && !this->state->remote_values.get_state()) {
-    previous_state_ = false;
+  return 0;
+}
+
+/// @brief Envoie les paramètres d'un mode à l'Arduino Mega, s'ils ont changé depuis le dernier envoi.
+/// @param effect Le mode.
+void ConnectedBedroomRGBLEDStrip::write_effect_parameters(ConnectedBedroomRGBLEDStripEffect *effect) {
+  std::string frame = this->get_effect_parameters_frame_(effect);
+  if (!frame.empty())
+    this->parent_->send_frame(frame);
+}
+
+/// @brief Construit la trame des paramètres d'un mode (`0II015E` suivi de la vitesse, de l'intensité, de la palette et
+/// du gain du son sur 3 chiffres chacun). Une chaîne vide est retournée si l'Arduino Mega a déjà ces paramètres.
+/// @param effect Le mode.
+/// @return La trame, ou une chaîne vide.
+std::string ConnectedBedroomRGBLEDStrip::get_effect_parameters_frame_(ConnectedBedroomRGBLEDStripEffect *effect) {
+  effect->mark_parameters_sent();
+
+  const RGBLEDStripEffectParameters &parameters = effect->get_parameters();
+  uint8_t index = effect->get_effect();
+
+  if (this->sent_parameters_known_[index] &&
+      memcmp(&this->sent_parameters_[index], &parameters, sizeof(RGBLEDStripEffectParameters)) == 0)
+    return "";
+
+  this->sent_parameters_known_[index] = true;
+  this->sent_parameters_[index] = parameters;
+
+  return protocol::OrderRGBLEDStripEffectParameters::encode(this->communication_id_, index, parameters.speed,
+                                                            parameters.intensity, parameters.palette,
+                                                            parameters.sound_gain);
+}
+
+/// @brief Méthode enregistrant le périphérique auprès de l'objet principal du composant externe.
+void ConnectedBedroomAddressableLEDStrip::register_device() {
+  this->parent_->add_addressable_LED_strip(this->communication_id_, this);
+}
+
+/// @brief Alloue les tampons des pixels (avant l'initialisation de l'entité "light").
+void ConnectedBedroomAddressableLEDStrip::setup() {
+  this->leds_ = new uint8_t[this->num_leds_ * 3]();
+  this->sent_leds_ = new uint8_t[this->num_leds_ * 3]();
+  this->effect_data_ = new uint8_t[this->num_leds_]();
+}
+
+/// @brief Affiche l'image retardée par la limitation du débit dès que la liaison le permet.
+void ConnectedBedroomAddressableLEDStrip::loop() {
+  if (this->show_pending_ && int32_t(millis() - this->next_show_at_) >= 0)
+    this->schedule_show();
+}
+
+/// @brief Les tampons doivent être alloués avant l'initialisation de l'entité "light".
+/// @return La priorité d'initialisation.
+float ConnectedBedroomAddressableLEDStrip::get_setup_priority() const { return setup_priority::HARDWARE; }
 
-    this->parent_->write('0');
-    this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-    this->parent_->write('0');
-    this->parent_->write('0');
-    this->parent_->write('0');
-    this->parent_->write('\n');
+/// @brief Définit le nombre de DEL du ruban.
+/// @param num_leds Le nombre de DEL.
+void ConnectedBedroomAddressableLEDStrip::set_num_leds(uint16_t num_leds) { this->num_leds_ = num_leds; }
 
+/// @brief Retourne le nombre de DEL du ruban.
+/// @return Le nombre de DEL.
+int32_t ConnectedBedroomAddressableLEDStrip::size() const { return this->num_leds_; }
+
+/// @brief Méthode permettant d'obtenir les capacités du ruban de DEL adressables.
+/// @return Les capacités du ruban de DEL adressables.
+light::LightTraits ConnectedBedroomAddressableLEDStrip::get_traits() {
+  auto traits = light::LightTraits();
+  traits.set_supported_color_modes({light::ColorMode::RGB});
+  return traits;
+}
+
+/// @brief Envoie à l'Arduino Mega les pixels modifiés depuis la dernière image. Chaque plage de pixels de même couleur
+/// est codée `SSSNNNRRGGBB` (premier pixel, nombre de pixels, couleur en hexadécimal) ; les trames `0II050` sont
+/// suivies d'une trame `0II051` après laquelle l'Arduino Mega affiche l'image. Les images sont espacées selon le
+/// débit de la liaison.
+/// @param state L'état à définir.
+void ConnectedBedroomAddressableLEDStrip::write_state(light::LightState *state) {
+  uint32_t now = millis();
+  if (int32_t(now - this->next_show_at_) < 0) {
+    this->show_pending_ = true;
     return;
   }
 
-  if (state->get_effect_name() == "Arc-en-ciel") {
-    this->parent_->write('0');
-    this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-    this->parent_->write('0');
-    this->parent_->write('1');
-    this->parent_->write('1');
-    this->parent_->write('\n');
+  this->show_pending_ = false;
+  this->mark_shown_();
+
+  std::string payload;
+  size_t sent_bytes = 0;
+
+  for (uint16_t i = 0; i < this->num_leds_;) {
+    const uint8_t *color = this->leds_ + i * 3;
+    if (!this->full_refresh_ && memcmp(color, this->sent_leds_ + i * 3, 3) == 0) {
+      i++;
+      continue;
+    }
+
+    // Les pixels suivants de même couleur sont ajoutés à la plage, qu'ils aient été modifiés ou non.
+    uint16_t count = 1;
+    while (i + count < this->num_leds_ && memcmp(color, this->leds_ + (i + count) * 3, 3) == 0)
+      count++;
+
+    char record[13];
+    snprintf(record, sizeof(record), "%03u%03u%02X%02X%02X", unsigned(i), unsigned(count), color[0], color[1],
+             color[2]);
+
+    if (protocol::OrderPixels::length() + payload.size() + 12 > protocol::MEGA_LINE_MAX_LENGTH) {
+      this->parent_->send_frame(protocol::OrderPixels::encode(this->communication_id_) + payload);
+      sent_bytes += protocol::OrderPixels::length() + payload.size() + 1;
+      payload.clear();
+    }
+
+    payload += record;
+    i += count;
+  }
 
+  if (payload.empty() && sent_bytes == 0)
     return;
+
+  this->parent_->send_frame(protocol::OrderPixelsShow::encode(this->communication_id_) + payload);
+  sent_bytes += protocol::OrderPixelsShow::length() + payload.size() + 1;
+
+  memcpy(this->sent_leds_, this->leds_, this->num_leds_ * 3);
+  this->full_refresh_ = false;
+
+  uint32_t byte_rate = this->parent_->get_link_byte_rate();
+  if (byte_rate > 0)
+    this->next_show_at_ = now + sent_bytes * 1000 / byte_rate;
+}
+
+/// @brief Efface les données des modes adressables.
+void ConnectedBedroomAddressableLEDStrip::clear_effect_data() {
+  memset(this->effect_data_, 0, this->num_leds_);
+}
+
+/// @brief Force l'envoi de tous les pixels lors de la prochaine image (après un redémarrage de l'Arduino Mega).
+void ConnectedBedroomAddressableLEDStrip::force_full_refresh() {
+  this->full_refresh_ = true;
+  this->schedule_show();
+}
+
+/// @brief Retourne l'accès à un pixel du tampon.
+/// @param index L'index du pixel.
+/// @return L'accès au pixel.
+light::ESPColorView ConnectedBedroomAddressableLEDStrip::get_view_internal(int32_t index) const {
+  uint8_t *pixel = this->leds_ + index * 3;
+  return light::ESPColorView(pixel, pixel + 1, pixel + 2, nullptr, this->effect_data_ + index, &this->correction_);
+}
+
+/// @brief Crée la transition utilisée par défaut par le ruban de DEL RVB (interpolée par l'Arduino Mega).
+/// @return La transition.
+std::unique_ptr<light::LightTransformer> ConnectedBedroomRGBLEDStrip::create_default_transition() {
+  return make_unique<ConnectedBedroomRGBLEDStripTransition>(this);
+}
+
+/// @brief Envoie une transition à l'Arduino Mega, qui l'interpole lui-même (`0II014`, suivi de la couleur de départ,
+/// de la couleur d'arrivée, de la durée en millisecondes sur 5 chiffres et de l'état d'arrivée). Comme l'entité ne
+/// reçoit pas les valeurs intermédiaires, une transition qui en interrompt une autre part de la couleur interpolée de
+/// celle-ci, et non de ses valeurs de départ.
+/// @param start_values Les valeurs de départ.
+/// @param target_values Les valeurs d'arrivée.
+/// @param length La durée de la transition en millisecondes.
+/// @return `false` si la transition n'a pas été envoyée (un mode est actif) et doit être appliquée directement.
+bool ConnectedBedroomRGBLEDStrip::write_transition(const light::LightColorValues &start_values,
+                                                   const light::LightColorValues &target_values, uint32_t length) {
+  // L'index 0 correspond à l'absence de mode.
+  if (this->state->get_current_effect_index() != 0)
+    return false;
+
+  this->parent_->trace_command_start(this->communication_id_, TRACED_RGB_LED_STRIP);
+
+  if (length > protocol::MAX_TRANSITION_LENGTH) {
+    ESP_LOGW(TAG, "Transition of %u ms shortened to %u ms, the longest the Arduino supports.", unsigned(length),
+             unsigned(protocol::MAX_TRANSITION_LENGTH));
+    length = protocol::MAX_TRANSITION_LENGTH;
   }
 
-  else if (state->get_effect_name() == "Son-réaction") {
-    this->parent_->write('0');
-    this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-    this->parent_->write('0');
-    this->parent_->write('1');
-    this->parent_->write('2');
-    this->parent_->write('\n');
+  float start_r, start_g, start_b, target_r, target_g, target_b;
+  start_values.as_rgb(&start_r, &start_g, &start_b);
+  target_values.as_rgb(&target_r, &target_g, &target_b);
 
-    return;
+  uint8_t start[3] = {uint8_t(start_r * 255.0f), uint8_t(start_g * 255.0f), uint8_t(start_b * 255.0f)};
+  uint8_t target[3] = {uint8_t(target_r * 255.0f), uint8_t(target_g * 255.0f), uint8_t(target_b * 255.0f)};
+
+  uint32_t now = millis();
+  uint32_t elapsed = now - this->transition_started_at_;
+  if (elapsed < this->transition_length_) {
+    float progress = float(elapsed) / this->transition_length_;
+    for (uint8_t i = 0; i < 3; i++)
+      start[i] = this->transition_start_color_[i] +
+                 (this->transition_target_color_[i] - this->transition_start_color_[i]) * progress;
   }
 
-  else if (state->get_effect_name() == "Alarme") {
-    this->parent_->write('0');
-    this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-    this->parent_->write('0');
-    this->parent_->write('1');
-    this->parent_->write('3');
-    this->parent_->write('\n');
+  memcpy(this->transition_start_color_, start, 3);
+  memcpy(this->transition_target_color_, target, 3);
+  this->transition_started_at_ = now;
+  this->transition_length_ = length;
 
-    return;
+  this->previous_state_ = target_values.is_on();
+  if (this->previous_state_) {
+    this->sent_state_known_ = true;
+    this->sent_effect_ = RGB_LED_STRIP_NO_EFFECT;
+    memcpy(this->sent_color_, target, 3);
   }
 
-  float r, g, b;
-  state->current_values_as_rgb(&r, &g, &b, false);
+  std::string frame = protocol::OrderRGBLEDStripTransition::encode(this->communication_id_, start[0], start[1],
+                                                                   start[2], target[0], target[1], target[2], length,
+                                                                   this->previous_state_);
+  this->parent_->send_frame(frame, this->communication_id_);
+
+  return true;
+}
+
+/// @brief Constructeur de la transition d'un ruban de DEL RVB.
+/// @param strip Le ruban de DEL RVB.
+ConnectedBedroomRGBLEDStripTransition::ConnectedBedroomRGBLEDStripTransition(ConnectedBedroomRGBLEDStrip *strip)
+    : strip_(strip) {}
+
+/// @brief Démarre la transition : elle est envoyée en une seule trame à l'Arduino Mega.
+void ConnectedBedroomRGBLEDStripTransition::start() {
+  this->sent_ = this->strip_->write_transition(this->start_values_, this->target_values_, this->length_);
+}
+
+/// @brief Ne retourne aucune valeur intermédiaire lorsque l'Arduino Mega interpole la transition, pour ne pas envoyer
+/// une trame par étape. Sinon, les valeurs d'arrivée sont appliquées directement.
+/// @return Les valeurs à appliquer.
+optional<light::LightColorValues> ConnectedBedroomRGBLEDStripTransition::apply() {
+  if (this->sent_ || this->applied_)
+    return {};
+
+  this->applied_ = true;
+  return this->target_values_;
+}
+
+std::vector<ConnectedBedroomRGBLEDStripEffect *> ConnectedBedroomRGBLEDStripEffect::instances_;
+
+/// @brief Constructeur de la classe de base des modes du ruban de DEL RVB.
+/// @param name Le nom du mode de couleur.
+/// @param effect Le mode correspondant de l'Arduino Mega.
+ConnectedBedroomRGBLEDStripEffect::ConnectedBedroomRGBLEDStripEffect(const std::string &name,
+                                                                     RGBLEDStripEffects effect)
+    : LightEffect(name), effect_(effect) {
+  instances_.push_back(this);
+}
+
+/// @brief Le mode est exécuté par l'Arduino Mega : seuls ses paramètres modifiés pendant son exécution sont envoyés.
+void ConnectedBedroomRGBLEDStripEffect::apply() {
+  if (this->parameters_changed_ && this->strip_ != nullptr)
+    this->strip_->write_effect_parameters(this);
+}
 
-  int red = int(r * 255.0f);
-  int green = int(g * 255.0f);
-  int blue = int(b * 255.0f);
+/// @brief Définit la vitesse du mode.
+/// @param speed La vitesse (de 0 à 255).
+void ConnectedBedroomRGBLEDStripEffect::set_speed(uint8_t speed) {
+  this->parameters_.speed = speed;
+  this->parameters_changed_ = true;
+}
+
+/// @brief Définit l'intensité du mode.
+/// @param intensity L'intensité (de 0 à 255).
+void ConnectedBedroomRGBLEDStripEffect::set_intensity(uint8_t intensity) {
+  this->parameters_.intensity = intensity;
+  this->parameters_changed_ = true;
+}
+
+/// @brief Définit la palette de couleurs du mode.
+/// @param palette L'index de la palette dans l'Arduino Mega.
+void ConnectedBedroomRGBLEDStripEffect::set_palette(uint8_t palette) {
+  this->parameters_.palette = palette;
+  this->parameters_changed_ = true;
+}
+
+/// @brief Définit le gain appliqué au son par le mode.
+/// @param sound_gain Le gain (de 0 à 255).
+void ConnectedBedroomRGBLEDStripEffect::set_sound_gain(uint8_t sound_gain) {
+  this->parameters_.sound_gain = sound_gain;
+  this->parameters_changed_ = true;
+}
+
+/// @brief Définit le ruban de DEL RVB auquel appartient le mode.
+/// @param strip Le ruban de DEL RVB.
+void ConnectedBedroomRGBLEDStripEffect::set_strip(ConnectedBedroomRGBLEDStrip *strip) { this->strip_ = strip; }
 
-  this->parent_->write('0');
-  this->parent_->write_str(addZeros(this->communication_id_, 2).c_str());
-  this->parent_->write('0');
-  this->parent_->write('1');
-  this->parent_->write('0');
-  this->parent_->write_str(addZeros(red, 3).c_str());
-  this->parent_->write_str(addZeros(green, 3).c_str());
-  this->parent_->write_str(addZeros(blue, 3).c_str());
-  this->parent_->write('\n');
+/// @brief Retourne le mode correspondant de l'Arduino Mega.
+/// @return Le mode de l'Arduino Mega.
+RGBLEDStripEffects ConnectedBedroomRGBLEDStripEffect::get_effect() const { return this->effect_; }
+
+/// @brief Retourne les paramètres du mode.
+/// @return Les paramètres du mode.
+const RGBLEDStripEffectParameters &ConnectedBedroomRGBLEDStripEffect::get_parameters() const {
+  return this->parameters_;
 }
 
-/// @brief Méthode permettant de bloquer la prochaîne requête d'un ordre.
-void ConnectedBedroomRGBLEDStrip::block_next_write() { this->block_next_write_ = true; }
+/// @brief Signale que les paramètres actuels ont été traités par le ruban de DEL RVB.
+void ConnectedBedroomRGBLEDStripEffect::mark_parameters_sent() { this->parameters_changed_ = false; }
+
+/// @brief Retrouve l'instance de ce composant correspondant à un mode d'une entité "light".
+/// @param light_effect Le mode de l'entité.
+/// @return L'instance, ou `nullptr` s'il ne s'agit pas d'un mode de ce composant.
+ConnectedBedroomRGBLEDStripEffect *ConnectedBedroomRGBLEDStripEffect::find(const light::LightEffect *light_effect) {
+  for (auto instance : instances_) {
+    if (instance == light_effect)
+      return instance;
+  }
+
+  return nullptr;
+}
 
 /// @brief Constructeur de la classe représentant un mode pour le ruban de DEL RVB.
 /// @param name Le nom du mode de couleur.
 ConnectedBedroomRGBLEDStripRainbowEffect::ConnectedBedroomRGBLEDStripRainbowEffect(const std::string &name)
-    : LightEffect(name) {}
-
-/// @brief Méthode nécessaire pour instancier l'objet, mais non utilisée dans ce cas.
-void ConnectedBedroomRGBLEDStripRainbowEffect::apply() {}
+    : ConnectedBedroomRGBLEDStripEffect(name, RGB_LED_STRIP_RAINBOW_EFFECT) {}
 
 /// @brief Constructeur de la classe représentant un mode pour le ruban de DEL RVB.
 /// @param name Le nom du mode de couleur.
 ConnectedBedroomRGBLEDStripSoundreactEffect::ConnectedBedroomRGBLEDStripSoundreactEffect(const std::string &name)
-    : LightEffect(name) {}
-
-/// @brief Méthode nécessaire pour instancier l'objet, mais non utilisée dans ce cas.
-void ConnectedBedroomRGBLEDStripSoundreactEffect::apply() {}
+    : ConnectedBedroomRGBLEDStripEffect(name, RGB_LED_STRIP_SOUNDREACT_EFFECT) {}
 
 /// @brief Constructeur de la classe représentant un mode pour le ruban de DEL RVB.
 /// @param name Le nom du mode de couleur.
 ConnectedBedroomRGBLEDStripAlarmEffect::ConnectedBedroomRGBLEDStripAlarmEffect(const std::string &name)
-    : LightEffect(name) {}
-
-/// @brief Méthode nécessaire pour instancier l'objet, mais non utilisée dans ce cas.
-void ConnectedBedroomRGBLEDStripAlarmEffect::apply() {}
+    : ConnectedBedroomRGBLEDStripEffect(name, RGB_LED_STRIP_ALARM_EFFECT) {}
 
 }  // namespace connected_bedroom
 }  // namespace esphome
\ No newline at end of file
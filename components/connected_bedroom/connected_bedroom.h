@@ -1,6 +1,7 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/binary_sensor/binary_sensor.h"
 #include "esphome/components/switch/switch.h"
@@ -9,8 +10,11 @@
 #include "esphome/components/number/number.h"
 #include "esphome/components/light/light_output.h"
 #include "esphome/components/light/light_effect.h"
+#include "esphome/components/light/light_transformer.h"
+#include "esphome/components/light/addressable_light.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/components/api/custom_api_device.h"
+#include "protocol.h"
 
 namespace esphome {
 namespace connected_bedroom {
@@ -23,8 +27,270 @@ enum ConnectedDeviceTypes {
   COLOR_VARIABLE_CONNECTED_LIGHT
 };
 
+/// @brief Modes des rubans de DEL RVB gérés par l'Arduino Mega (la valeur est utilisée directement dans les trames).
+enum RGBLEDStripEffects : uint8_t {
+  RGB_LED_STRIP_NO_EFFECT,
+  RGB_LED_STRIP_RAINBOW_EFFECT,
+  RGB_LED_STRIP_SOUNDREACT_EFFECT,
+  RGB_LED_STRIP_ALARM_EFFECT,
+  RGB_LED_STRIP_EFFECTS_COUNT
+};
+
+/// @brief Paramètres d'un mode d'un ruban de DEL RVB, transmis à l'Arduino Mega qui exécute le mode.
+struct RGBLEDStripEffectParameters {
+  uint8_t speed;
+  uint8_t intensity;
+  uint8_t palette;
+  uint8_t sound_gain;
+};
+
+/// @brief Types d'états mémorisés dans la mémoire persistante, pour pouvoir les publier dès le démarrage.
+enum PersistedStateKinds : uint8_t {
+  PERSISTED_SWITCH_STATE,
+  PERSISTED_ALARM_STATE,
+  PERSISTED_MISSILES_COUNT,
+  PERSISTED_TELEVISION_STATE,
+  PERSISTED_TELEVISION_VOLUME,
+  PERSISTED_TELEVISION_MUTED,
+  PERSISTED_RGB_LED_STRIP_STATE,
+  PERSISTED_RGB_LED_STRIP_COLOR
+};
+
+/// @brief Nombre maximal d'états mémorisés dans la mémoire persistante.
+static const uint8_t MAX_PERSISTED_STATES = 32;
+
+/// @brief Dernier état connu d'un périphérique, tel que confirmé par l'Arduino Mega.
+struct PersistedState {
+  uint8_t communication_id;
+  uint8_t kind;
+  uint8_t values[3];
+} __attribute__((packed));
+
+/// @brief Version de l'état d'un périphérique, attribuée par l'Arduino Mega à chaque changement d'état.
+struct DeviceVersion {
+  uint8_t communication_id;
+  uint16_t version;
+} __attribute__((packed));
+
+/// @brief Époque inconnue : aucune synchronisation différentielle n'est possible.
+static const uint16_t UNKNOWN_EPOCH = 0xFFFF;
+
+/// @brief Image compacte des derniers états connus, enregistrée dans la mémoire persistante. Les versions associées
+/// (valables pour l'époque de l'Arduino Mega) permettent de ne demander que les états modifiés depuis.
+struct PersistedStates {
+  uint8_t count;
+  PersistedState states[MAX_PERSISTED_STATES];
+  uint16_t epoch;
+  uint8_t version_count;
+  DeviceVersion versions[MAX_PERSISTED_STATES];
+} __attribute__((packed));
+
+/// @brief Nombre maximal de messages en attente d'être prononcés par l'enceinte.
+static const uint8_t SPEECH_QUEUE_SIZE = 8;
+
+/// @brief Message de l'Arduino Mega en attente d'être prononcé par l'enceinte.
+struct PendingSpeech {
+  std::string message;
+  bool priority;
+};
+
+/// @brief Nombre maximal de longues trames en attente d'envoi par morceaux.
+static const uint8_t BULK_QUEUE_SIZE = 4;
+
+/// @brief Nombre maximal de morceaux d'une longue trame (numérotés sur deux chiffres).
+static const uint8_t MAX_CHUNKS = 99;
+
+/// @brief Nombre maximal de trames critiques en attente d'acquittement.
+static const uint8_t RETRANSMIT_WINDOW_SIZE = 4;
+
+/// @brief Trame critique envoyée à l'Arduino Mega, en attente de son acquittement.
+struct PendingFrame {
+  std::string frame;
+  uint8_t sequence{0};
+  uint8_t attempts{0};
+  uint32_t sent_at{0};
+  bool active{false};
+};
+
+/// @brief Nombre maximal de valeurs dans une trame de mise à jour d'un capteur à plusieurs valeurs.
+static const uint8_t MAX_SENSOR_SLOTS = 8;
+
+/// @brief Capteur de l'Arduino Mega envoyant plusieurs valeurs dans une même trame : entité et échelle de chaque
+/// valeur.
+struct MultiValueSensor {
+  int communication_id;
+  sensor::Sensor *sensors[MAX_SENSOR_SLOTS];
+  float scales[MAX_SENSOR_SLOTS];
+};
+
+/// @brief Nombre maximal de mises à jour d'entités en attente de publication pendant la lecture des trames reçues.
+static const uint8_t MAX_STAGED_UPDATES = 16;
+
+/// @brief Types d'entités dont la publication des mises à jour est regroupée.
+enum StagedEntityTypes : uint8_t { STAGED_SWITCH, STAGED_BINARY_SENSOR, STAGED_SENSOR, STAGED_NUMBER, STAGED_ALARM };
+
+/// @brief Emplacements des entités d'un même périphérique (un capteur à plusieurs valeurs utilise le numéro de la
+/// valeur).
+enum StagedSlots : uint8_t {
+  STAGED_SLOT_STATE,
+  STAGED_SLOT_VOLUME,
+  STAGED_SLOT_VOLUME_NUMBER,
+  STAGED_SLOT_MUTED,
+  STAGED_SLOT_BASE,
+  STAGED_SLOT_ANGLE,
+  STAGED_SLOT_MISSILES
+};
+
+/// @brief Mise à jour d'une entité reçue pendant la lecture des trames : seule la dernière valeur de chaque entité
+/// (identifiant de communication et emplacement) est publiée, à la fin de la lecture.
+struct StagedUpdate {
+  int communication_id;
+  uint8_t slot;
+  StagedEntityTypes type;
+  EntityBase *entity;
+  float value;
+};
+
+/// @brief Valeur indiquant qu'un axe d'un lance-missile ne doit pas être modifié par une visée.
+static const int AIM_AXIS_UNCHANGED = 999;
+
+/// @brief Visée d'un lance-missile en attente d'envoi (les déplacements des curseurs sont regroupés).
+struct PendingAim {
+  int communication_id;
+  int base;
+  int angle;
+  uint32_t requested_at;
+};
+
+/// @brief Types de périphériques dont les commandes peuvent être tracées.
+enum TracedDeviceTypes : uint8_t {
+  TRACED_SWITCH,
+  TRACED_ALARM,
+  TRACED_MISSILE_LAUNCHER,
+  TRACED_TELEVISION,
+  TRACED_RGB_LED_STRIP,
+  TRACED_DEVICE_TYPES_COUNT
+};
+
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+/// @brief Nombre de classes des histogrammes de latence (la dernière regroupe les valeurs hors limites).
+static const uint8_t LATENCY_BUCKETS_COUNT = 14;
+
+/// @brief Nombre maximal de commandes tracées simultanément.
+static const uint8_t MAX_TRACED_COMMANDS = 4;
+
+/// @brief Commande en cours de traçage, de son entrée dans le composant jusqu'à sa confirmation par l'Arduino Mega.
+struct CommandTrace {
+  int communication_id{-1};
+  uint8_t type{0};
+  uint32_t started_at{0};
+  uint32_t written_at{0};
+  bool written{false};
+  bool active{false};
+};
+
+/// @brief Histogrammes de latence d'un type de périphérique : écriture sur l'UART et confirmation par l'Arduino Mega.
+struct LatencyHistogram {
+  uint32_t write[LATENCY_BUCKETS_COUNT];
+  uint32_t confirm[LATENCY_BUCKETS_COUNT];
+};
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_PROFILER
+/// @brief Phases de `ConnectedBedroom::loop()` mesurées par le profileur.
+enum LoopPhases : uint8_t {
+  PHASE_LOOP,
+  PHASE_RX_DRAIN,
+  PHASE_DECODE,
+  PHASE_LOOKUP,
+  PHASE_PUBLISH,
+  PHASE_LIGHT_CALL,
+  PHASE_HA_SERVICE,
+  LOOP_PHASES_COUNT
+};
+
+/// @brief Nombre de classes (puissances de 2 du nombre de cycles) des histogrammes du profileur.
+static const uint8_t PROFILER_BUCKETS_COUNT = 24;
+
+/// @brief Profondeur maximale d'imbrication des phases mesurées.
+static const uint8_t PROFILER_MAX_DEPTH = 8;
+
+/// @brief Mesures d'une phase : histogramme logarithmique et pire cas.
+struct PhaseProfile {
+  uint32_t count;
+  uint64_t total_cycles;
+  uint32_t max_cycles;
+  uint32_t max_at;
+  uint32_t buckets[PROFILER_BUCKETS_COUNT];
+};
+
+/// @brief Profileur de `ConnectedBedroom::loop()`, basé sur le compteur de cycles du processeur. Le temps d'une phase
+/// imbriquée est déduit de celui de la phase qui la contient.
+class LoopProfiler {
+ public:
+  void enter();
+  void exit(LoopPhases phase);
+
+  void dump() const;
+  void reset();
+
+ protected:
+  uint8_t depth_{0};
+  uint32_t started_at_[PROFILER_MAX_DEPTH]{};
+  uint32_t child_cycles_[PROFILER_MAX_DEPTH]{};
+  PhaseProfile profiles_[LOOP_PHASES_COUNT]{};
+};
+
+/// @brief Mesure d'une phase, de la construction à la destruction de l'objet.
+class LoopProfilerScope {
+ public:
+  LoopProfilerScope(LoopProfiler *profiler, LoopPhases phase);
+  ~LoopProfilerScope();
+
+ protected:
+  LoopProfiler *profiler_;
+  LoopPhases phase_;
+};
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_SOAK_TEST
+/// @brief Compteurs du trafic de la liaison, consultés lors des tests d'endurance.
+struct LinkStatistics {
+  uint32_t rx_frames;
+  uint32_t tx_frames;
+  uint32_t tx_bytes;
+  uint32_t ha_callbacks;
+};
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_RECORDER
+/// @brief Sens des octets enregistrés par l'enregistreur du trafic UART.
+enum TrafficDirections : uint8_t { TRAFFIC_RX, TRAFFIC_TX };
+
+/// @brief Nombre maximal d'octets dans un enregistrement du trafic UART.
+static const uint8_t TRAFFIC_RECORD_DATA_SIZE = 10;
+
+/// @brief Octets consécutifs échangés dans un même sens et dans la même milliseconde.
+struct TrafficRecord {
+  uint32_t timestamp;
+  uint8_t direction;
+  uint8_t length;
+  uint8_t data[TRAFFIC_RECORD_DATA_SIZE];
+};
+#endif
+
 class ConnectedBedroomTelevision;
 class ConnectedBedroomRGBLEDStrip;
+class ConnectedBedroomAddressableLEDStrip;
+class ConnectedBedroomRGBLEDStripEffect;
+class ConnectedBedroom;
+
+/// @brief Entrée de la table de décodage des trames reçues de l'Arduino Mega : type de trame (décrit dans
+/// `protocol.h`) et méthode qui la traite.
+struct FrameRoute {
+  bool (*matches)(const std::vector<uint8_t> &frame);
+  void (ConnectedBedroom::*handle)(int communication_id);
+};
 
 /// @brief Classe de gestion de la communication entre l'Arduino Mega et Home Assistant.
 class ConnectedBedroom : public Component, public uart::UARTDevice, public api::CustomAPIDevice {
@@ -36,7 +302,9 @@ class ConnectedBedroom : public Component, public uart::UARTDevice, public api::
 
   // Méthodes permettant d'enregistrer les périphériques utilisés à l'initialisation.
   void add_analog_sensor(int communication_id, sensor::Sensor *analog_sensor);
-  void add_binary_sensor(int communication_id, binary_sensor::BinarySensor *binary_sensor);
+  void add_analog_sensor_slot(int communication_id, uint8_t slot, float scale, sensor::Sensor *analog_sensor);
+  void add_binary_sensor(int communication_id, binary_sensor::BinarySensor *binary_sensor,
+                         bool publish_every_transition = false);
   void add_switch(int communication_id, switch_::Switch *switch_);
   void add_alarm(int communication_id, alarm_control_panel::AlarmControlPanel *alarm);
   void add_alarm_missile_launcher_base_number(int communication_id, number::Number *number);
@@ -46,9 +314,165 @@ class ConnectedBedroom : public Component, public uart::UARTDevice, public api::
   void add_television(int communication_id, ConnectedBedroomTelevision *television);
   void add_connected_device(int communication_id, std::string entity_id, ConnectedDeviceTypes type);
   void add_RGB_LED_strip(int communication_id, ConnectedBedroomRGBLEDStrip *light);
+  void add_addressable_LED_strip(int communication_id, ConnectedBedroomAddressableLEDStrip *light);
+
+  // Méthodes permettant de configurer la mémorisation des derniers états connus.
+  void set_restore_states(bool restore_states);
+  void set_state_save_interval(uint32_t state_save_interval);
+  void set_preference_key(const std::string &preference_key);
+
+  // Méthode permettant de distinguer les services de plusieurs instances du composant (microcontrôleurs d'un bus).
+  void set_service_suffix(const std::string &service_suffix);
+
+  // Méthodes permettant de configurer la livraison fiable des trames critiques.
+  void set_reliable_commands(bool reliable_commands);
+  void set_retransmit_timeout(uint32_t retransmit_timeout);
+  void set_max_retransmits(uint8_t max_retransmits);
+
+  // Méthodes permettant de configurer la surveillance de la liaison avec l'Arduino Mega.
+  void set_heartbeat_interval(uint32_t heartbeat_interval);
+  void set_max_missed_heartbeats(uint8_t max_missed_heartbeats);
+  void set_rtt_sensor(sensor::Sensor *rtt_sensor);
+  void set_jitter_sensor(sensor::Sensor *jitter_sensor);
+  void set_link_sensor(binary_sensor::BinarySensor *link_sensor);
+
+#ifdef USE_CONNECTED_BEDROOM_RECORDER
+  // Méthode permettant de configurer l'enregistreur du trafic UART.
+  void set_traffic_recorder_size(uint16_t traffic_recorder_size);
+#endif
+
+  // Méthodes permettant de viser avec un lance-missile (les deux axes dans une même trame).
+  void set_aim_coalescing_window(uint32_t aim_coalescing_window);
+  void aim_missile_launcher(int communication_id, int base, int angle);
+  void flush_missile_launcher_aim(int communication_id);
+
+  // Méthode permettant de définir la géométrie de l'écran de l'Arduino Mega (mise en forme des messages).
+  void set_display_geometry(uint8_t columns, uint8_t rows, uint8_t max_pages);
+
+  // Méthode permettant de définir les musiques préenregistrées (stockées en mémoire flash).
+  void set_music_presets(const uint8_t *music_presets, uint16_t music_presets_count);
+
+  // Méthodes permettant d'envoyer une trame à l'Arduino Mega.
+  void send_frame(const std::string &frame, int traced_communication_id = -1);
+  void send_critical_frame(const std::string &frame, int traced_communication_id = -1);
+  void send_bulk_frame(const std::string &frame);
+
+  // Méthodes permettant de configurer le rythme des messages prononcés par l'enceinte.
+  void set_speech_min_interval(uint32_t speech_min_interval);
+  void set_speech_characters_per_second(uint8_t speech_characters_per_second);
+
+  // Méthode permettant de regrouper dans une même trame les mises à jour envoyées ensemble à l'Arduino Mega.
+  void set_batch_frames(bool batch_frames);
+
+  // Méthode permettant de configurer l'envoi par morceaux des longues trames.
+  void set_chunked_transmit(uint8_t chunk_size, uint8_t initial_credit, uint32_t credit_timeout);
+
+  // Méthode permettant de connaître le débit de la liaison avec l'Arduino Mega.
+  uint32_t get_link_byte_rate() const;
+
+  // Méthode permettant de tracer la latence d'une commande (sans effet si le traçage n'est pas compilé).
+  void trace_command_start(int communication_id, TracedDeviceTypes type);
 
  protected:
   void process_message_();
+  void process_batch_();
+  void dispatch_frame_();
+
+  // Méthodes de traitement des trames reçues de l'Arduino Mega (voir `FRAME_ROUTES`).
+  void handle_connected_device_power_(int communication_id);
+  template<typename Frame> void handle_connected_light_temperature_(int communication_id);
+  template<typename Frame> void handle_connected_light_brightness_(int communication_id);
+  void handle_connected_light_color_(int communication_id);
+  void handle_power_update_(int communication_id);
+  void handle_RGB_LED_strip_color_update_(int communication_id);
+  void handle_RGB_LED_strip_effect_update_(int communication_id);
+  void handle_alarm_armed_update_(int communication_id);
+  void handle_alarm_triggered_update_(int communication_id);
+  void handle_missile_launcher_base_update_(int communication_id);
+  void handle_missile_launcher_angle_update_(int communication_id);
+  void handle_missile_launcher_missiles_update_(int communication_id);
+  void handle_missile_launcher_aim_update_(int communication_id);
+  void handle_television_volume_update_(int communication_id);
+  void handle_television_muted_update_(int communication_id);
+  void handle_television_unmuted_update_(int communication_id);
+  void handle_binary_sensor_update_(int communication_id);
+  void handle_analog_sensor_update_(int communication_id);
+  void handle_temperature_sensor_update_(int communication_id);
+  void handle_multi_value_sensor_update_(int communication_id);
+  void handle_speech_message_(int communication_id);
+  void handle_synchronization_request_(int communication_id);
+  void handle_shutdown_request_(int communication_id);
+  void handle_epoch_(int communication_id);
+  void handle_acknowledgement_(int communication_id);
+  void handle_pong_(int communication_id);
+  void handle_chunk_credit_(int communication_id);
+  void handle_music_(int communication_id);
+  void handle_music_preset_(int communication_id);
+
+  static const FrameRoute FRAME_ROUTES[];
+
+  // Méthodes permettant de gérer la mémorisation des derniers états connus.
+  void publish_persisted_states_();
+  void remember_state_(int communication_id, PersistedStateKinds kind, uint8_t value_1, uint8_t value_2 = 0,
+                       uint8_t value_3 = 0);
+  void save_states_();
+
+  // Méthodes permettant de gérer la synchronisation différentielle avec l'Arduino Mega.
+  void request_synchronization_();
+  void remember_version_(int communication_id, uint16_t version);
+  void set_epoch_(uint16_t epoch);
+
+  // Méthodes permettant de gérer la livraison fiable des trames critiques.
+  void acknowledge_frame_(uint8_t sequence);
+  void process_retransmissions_();
+
+  // Méthodes permettant de surveiller la liaison avec l'Arduino Mega.
+  void process_heartbeat_();
+  void receive_pong_(uint16_t sequence);
+  void mark_link_alive_();
+  void set_link_state_(bool link_up);
+
+  // Méthodes permettant d'envoyer les visées des lance-missiles.
+  void process_aims_();
+  void process_bulk_frames_();
+  void queue_speech_(const std::string &message, bool priority);
+  void process_speech_queue_();
+  void receive_chunk_credit_(uint8_t credit);
+  void send_aim_(const PendingAim &aim);
+
+  // Méthodes permettant de regrouper les publications des mises à jour reçues pendant la lecture des trames.
+  void stage_update_(int communication_id, uint8_t slot, StagedEntityTypes type, EntityBase *entity, float value);
+  void publish_staged_updates_();
+  void publish_update_(const StagedUpdate &update);
+
+  // Méthodes permettant de tracer la latence des commandes.
+  void trace_command_written_(int communication_id);
+  void trace_command_confirmed_(int communication_id);
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+  void dump_command_latency_();
+  void reset_command_latency_();
+#endif
+
+  // Méthodes des services de test d'endurance.
+  void count_ha_callback_();
+#ifdef USE_CONNECTED_BEDROOM_SOAK_TEST
+  void dump_link_statistics_();
+  void reset_link_statistics_();
+  void inject_frame_(std::string frame);
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_RECORDER
+  // Méthodes de l'enregistreur du trafic UART.
+  void record_traffic_(TrafficDirections direction, const uint8_t *data, size_t length);
+  void dump_traffic_();
+  void clear_traffic_();
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_PROFILER
+  // Méthodes permettant de consulter et réinitialiser les mesures du profileur.
+  void dump_loop_profile_();
+  void reset_loop_profile_();
+#endif
 
   void send_message_to_Arduino_(std::string title, std::string message);
 
@@ -57,10 +481,14 @@ class ConnectedBedroom : public Component, public uart::UARTDevice, public api::
   void update_connected_light_brightness_(std::string entity_id, std::string state);
   void update_connected_light_temperature_(std::string entity_id, std::string state);
   void update_connected_light_color_(std::string entity_id, std::string state);
+  void queue_connected_update_(const std::string &frame);
+  void send_connected_updates_();
 
   // Méthodes permettant de récupérer des périphériques à partir de leur identifiant unique de communication, et
   // inversement (et autres).
   sensor::Sensor *get_analog_sensor_from_communication_id_(int communication_id) const;
+  const MultiValueSensor *get_multi_value_sensor_from_communication_id_(int communication_id) const;
+  bool get_music_preset_(int index, std::string &url) const;
   binary_sensor::BinarySensor *get_binary_sensor_from_communication_id_(int communication_id) const;
   switch_::Switch *get_switch_from_communication_id_(int communication_id) const;
   alarm_control_panel::AlarmControlPanel *get_alarm_from_communication_id_(int communication_id) const;
@@ -79,8 +507,111 @@ class ConnectedBedroom : public Component, public uart::UARTDevice, public api::
 
   bool synchronized_{false};
 
+  // Attributs de la mémorisation des derniers états connus.
+  bool restore_states_{true};
+  uint32_t state_save_interval_{60000};
+  std::string preference_key_{"connected_bedroom"};
+  ESPPreferenceObject states_preference_;
+  PersistedStates persisted_states_{};
+
+  // Suffixe ajouté au nom des services (adresse du microcontrôleur sur un bus partagé).
+  std::string service_suffix_;
+  bool states_dirty_{false};
+  bool states_overflow_logged_{false};
+  uint32_t last_states_save_{0};
+
+  // Attributs de la livraison fiable des trames critiques.
+  bool reliable_commands_{false};
+  uint32_t retransmit_timeout_{200};
+  uint8_t max_retransmits_{3};
+  uint8_t next_sequence_{0};
+  PendingFrame pending_frames_[RETRANSMIT_WINDOW_SIZE];
+
+  // Attributs de la surveillance de la liaison avec l'Arduino Mega.
+  uint32_t heartbeat_interval_{0};
+  uint8_t max_missed_heartbeats_{3};
+  sensor::Sensor *rtt_sensor_{nullptr};
+  sensor::Sensor *jitter_sensor_{nullptr};
+  binary_sensor::BinarySensor *link_sensor_{nullptr};
+  uint16_t ping_sequence_{0};
+  uint32_t ping_sent_at_{0};
+  bool ping_pending_{false};
+  uint8_t missed_heartbeats_{0};
+  float last_rtt_{NAN};
+  float jitter_{0.0f};
+  bool link_up_{true};
+  uint32_t link_up_since_{0};
+  uint32_t resync_backoff_{1000};
+  uint32_t last_automatic_resync_{0};
+  bool resync_pending_{false};
+
+  // Géométrie de l'écran de l'Arduino Mega (`0` colonne : messages envoyés sans mise en forme).
+  uint8_t display_columns_{0};
+  uint8_t display_rows_{0};
+  uint8_t display_max_pages_{0};
+
+  // Musiques préenregistrées : URL terminées par un caractère nul, à la suite les unes des autres en mémoire flash.
+  const uint8_t *music_presets_{nullptr};
+  uint16_t music_presets_count_{0};
+
+  // Attributs du regroupement des publications des mises à jour reçues (capteurs binaires publiant chaque transition).
+  StagedUpdate staged_updates_[MAX_STAGED_UPDATES];
+  uint8_t staged_updates_count_{0};
+  bool staging_updates_{false};
+  std::vector<int> every_transition_binary_sensors_;
+
+  // Attributs du regroupement des visées des lance-missiles.
+  uint32_t aim_coalescing_window_{100};
+  std::vector<PendingAim> pending_aims_;
+
+  // Attributs de la file des messages prononcés par l'enceinte.
+  uint32_t speech_min_interval_{1000};
+  uint8_t speech_characters_per_second_{14};
+  std::vector<PendingSpeech> speech_queue_;
+  std::string last_speech_;
+  uint32_t next_speech_at_{0};
+
+  // Attributs du regroupement des mises à jour des périphériques connectés envoyées à l'Arduino Mega.
+  bool batch_frames_{false};
+  std::vector<std::string> pending_connected_updates_;
+
+  // Attributs de l'envoi par morceaux des longues trames (`0` octet par morceau : envoi en une fois).
+  uint8_t chunk_size_{0};
+  uint8_t initial_chunk_credit_{2};
+  uint32_t chunk_credit_timeout_{500};
+  std::vector<std::string> bulk_frames_;
+  uint8_t chunk_index_{0};
+  uint8_t chunk_credit_{0};
+  uint32_t last_chunk_credit_{0};
+  uint32_t next_chunk_at_{0};
+
+#ifdef USE_CONNECTED_BEDROOM_TRACING
+  // Attributs du traçage de la latence des commandes.
+  CommandTrace command_traces_[MAX_TRACED_COMMANDS];
+  LatencyHistogram latency_histograms_[TRACED_DEVICE_TYPES_COUNT]{};
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_SOAK_TEST
+  // Compteurs du trafic de la liaison.
+  LinkStatistics link_statistics_{};
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_RECORDER
+  // Attributs de l'enregistreur du trafic UART (tampon circulaire alloué à l'initialisation).
+  std::vector<TrafficRecord> traffic_records_;
+  uint16_t traffic_recorder_size_{64};
+  uint16_t traffic_head_{0};
+  uint16_t traffic_count_{0};
+#endif
+
+#ifdef USE_CONNECTED_BEDROOM_PROFILER
+  // Profileur de la boucle (modifiable depuis les méthodes constantes de recherche des périphériques).
+  mutable LoopProfiler loop_profiler_;
+#endif
+
   // Attributs de stockage des périphériques utilisés dans la communication.
   std::vector<std::pair<int, sensor::Sensor *>> analog_sensors_;
+  std::vector<MultiValueSensor> multi_value_sensors_;
   std::vector<std::pair<int, binary_sensor::BinarySensor *>> binary_sensors_;
   std::vector<std::pair<int, switch_::Switch *>> switches_;
   std::vector<std::tuple<int, alarm_control_panel::AlarmControlPanel *, number::Number *, number::Number *,
@@ -88,6 +619,7 @@ class ConnectedBedroom : public Component, public uart::UARTDevice, public api::
       alarms_;
   std::vector<std::pair<int, ConnectedBedroomTelevision *>> televisions_;
   std::vector<std::pair<int, ConnectedBedroomRGBLEDStrip *>> RGB_LED_strips_;
+  std::vector<std::pair<int, ConnectedBedroomAddressableLEDStrip *>> addressable_LED_strips_;
   std::vector<std::tuple<int, std::string, ConnectedDeviceTypes>> connected_lights_;
 
   friend class light::LightState;
@@ -221,6 +753,16 @@ class TelevisionVolumeDown : public button::Button, public TelevisionComponent {
   void press_action() override;
 };
 
+/// @brief Classe représentant le contrôle du volume d'une télévision du système de domotique : apparaît comme une
+/// entité "number". L'Arduino Mega atteint lui-même le volume demandé et n'envoie que le volume final.
+class TelevisionVolume : public number::Number, public TelevisionComponent {
+ public:
+  void register_component() override;
+
+ protected:
+  void control(float value) override;
+};
+
 /// @brief Classe représentant une télévision du système de domotique. Celle-ci intègre les différentes classes de
 /// contrôle de la télévision.
 class ConnectedBedroomTelevision : public Component, public ConnectedBedroomDevice {
@@ -233,6 +775,7 @@ class ConnectedBedroomTelevision : public Component, public ConnectedBedroomDevi
   TelevisionMuted *muted;
   TelevisionVolumeUp *volume_up;
   TelevisionVolumeDown *volume_down;
+  TelevisionVolume *volume_number{nullptr};
   sensor::Sensor *volume;
 
  protected:
@@ -240,6 +783,7 @@ class ConnectedBedroomTelevision : public Component, public ConnectedBedroomDevi
   friend class TelevisionMuted;
   friend class TelevisionVolumeUp;
   friend class TelevisionVolumeDown;
+  friend class TelevisionVolume;
 };
 
 /// @brief Classe représentant un ruban de DEL RVB du système de domotique : apparaît comme une entité "light".
@@ -252,37 +796,143 @@ class ConnectedBedroomRGBLEDStrip : public Component, public light::LightOutput,
   void setup_state(light::LightState *state) override;
   void write_state(light::LightState *state) override;
 
-  void block_next_write();
+  std::unique_ptr<light::LightTransformer> create_default_transition() override;
+  bool write_transition(const light::LightColorValues &start_values, const light::LightColorValues &target_values,
+                        uint32_t length);
+
+  // Méthodes permettant d'enregistrer un état confirmé par l'Arduino Mega (après l'avoir appliqué à l'entité), pour ne
+  // pas le lui renvoyer.
+  void confirm_power(bool power);
+  void confirm_color();
+  void confirm_effect(RGBLEDStripEffects effect);
+
+  uint32_t get_effect_index(RGBLEDStripEffects effect) const;
+  void write_effect_parameters(ConnectedBedroomRGBLEDStripEffect *effect);
 
   light::LightState *state{nullptr};
 
  protected:
-  bool block_next_write_{false};
+  void remember_sent_state_(bool power, RGBLEDStripEffects effect, const uint8_t color[3]);
+  void get_output_color_(uint8_t color[3]) const;
+  ConnectedBedroomRGBLEDStripEffect *get_current_effect_() const;
+  std::string get_effect_parameters_frame_(ConnectedBedroomRGBLEDStripEffect *effect);
+
   bool previous_state_{false};
+
+  // Mode de ce composant correspondant à chaque mode de l'entité (l'index 0 correspond à l'absence de mode ; un
+  // pointeur nul à un mode d'un autre composant).
+  std::vector<ConnectedBedroomRGBLEDStripEffect *> effects_;
+
+  // Dernier état envoyé à l'Arduino Mega ou confirmé par celui-ci, champ par champ (alimentation dans
+  // `previous_state_`, mode, couleur) : seuls les champs différents sont envoyés, ce qui supprime les échos des mises à
+  // jour sans jamais ignorer une commande.
+  bool sent_state_known_{false};
+  RGBLEDStripEffects sent_effect_{RGB_LED_STRIP_NO_EFFECT};
+  uint8_t sent_color_[3]{};
+  RGBLEDStripEffectParameters sent_parameters_[RGB_LED_STRIP_EFFECTS_COUNT]{};
+  bool sent_parameters_known_[RGB_LED_STRIP_EFFECTS_COUNT]{};
+
+  // Dernière transition envoyée à l'Arduino Mega (durée nulle si une autre trame l'a remplacée) : une transition qui
+  // l'interrompt avant sa fin part de la couleur que l'Arduino Mega affiche à cet instant.
+  uint8_t transition_start_color_[3]{};
+  uint8_t transition_target_color_[3]{};
+  uint32_t transition_started_at_{0};
+  uint32_t transition_length_{0};
 };
 
-/// @brief Classe représentant le mode arc-en-ciel d'un ruban de DEL RVB du système de domotique.
-class ConnectedBedroomRGBLEDStripRainbowEffect : public light::LightEffect {
+/// @brief Classe représentant un ruban de DEL adressables du système de domotique : apparaît comme une entité "light"
+/// compatible avec les modes adressables d'ESPHome. Seuls les pixels modifiés depuis la dernière image envoyée sont
+/// transmis, regroupés par plages de même couleur.
+class ConnectedBedroomAddressableLEDStrip : public light::AddressableLight, public ConnectedBedroomDevice {
  public:
-  explicit ConnectedBedroomRGBLEDStripRainbowEffect(const std::string &name);
+  void register_device() override;
+
+  void setup() override;
+  void loop() override;
+  float get_setup_priority() const override;
+
+  void set_num_leds(uint16_t num_leds);
+  int32_t size() const override;
+
+  light::LightTraits get_traits() override;
+  void write_state(light::LightState *state) override;
+  void clear_effect_data() override;
+
+  void force_full_refresh();
+
+ protected:
+  light::ESPColorView get_view_internal(int32_t index) const override;
+
+  uint16_t num_leds_{0};
+  uint8_t *leds_{nullptr};
+  uint8_t *sent_leds_{nullptr};
+  uint8_t *effect_data_{nullptr};
+  bool full_refresh_{true};
+  bool show_pending_{false};
+  uint32_t next_show_at_{0};
+};
+
+/// @brief Classe représentant une transition d'un ruban de DEL RVB, interpolée par l'Arduino Mega.
+class ConnectedBedroomRGBLEDStripTransition : public light::LightTransformer {
+ public:
+  explicit ConnectedBedroomRGBLEDStripTransition(ConnectedBedroomRGBLEDStrip *strip);
+
+  void start() override;
+  optional<light::LightColorValues> apply() override;
+
+ protected:
+  ConnectedBedroomRGBLEDStrip *strip_;
+  bool sent_{false};
+  bool applied_{false};
+};
+
+/// @brief Classe de base des modes d'un ruban de DEL RVB, exécutés par l'Arduino Mega. Les instances sont
+/// répertoriées pour que le ruban puisse retrouver, à l'initialisation, le mode de l'Arduino Mega correspondant à
+/// chacun de ses modes (sans comparer les noms).
+class ConnectedBedroomRGBLEDStripEffect : public light::LightEffect {
+ public:
+  ConnectedBedroomRGBLEDStripEffect(const std::string &name, RGBLEDStripEffects effect);
 
   void apply() override;
+
+  // Méthodes permettant de définir les paramètres du mode (envoyés à l'Arduino Mega lorsqu'ils sont modifiés).
+  void set_speed(uint8_t speed);
+  void set_intensity(uint8_t intensity);
+  void set_palette(uint8_t palette);
+  void set_sound_gain(uint8_t sound_gain);
+
+  void set_strip(ConnectedBedroomRGBLEDStrip *strip);
+  RGBLEDStripEffects get_effect() const;
+  const RGBLEDStripEffectParameters &get_parameters() const;
+  void mark_parameters_sent();
+
+  static ConnectedBedroomRGBLEDStripEffect *find(const light::LightEffect *light_effect);
+
+ protected:
+  RGBLEDStripEffects effect_;
+  RGBLEDStripEffectParameters parameters_{128, 255, 0, 128};
+  bool parameters_changed_{false};
+  ConnectedBedroomRGBLEDStrip *strip_{nullptr};
+
+  static std::vector<ConnectedBedroomRGBLEDStripEffect *> instances_;
+};
+
+/// @brief Classe représentant le mode arc-en-ciel d'un ruban de DEL RVB du système de domotique.
+class ConnectedBedroomRGBLEDStripRainbowEffect : public ConnectedBedroomRGBLEDStripEffect {
+ public:
+  explicit ConnectedBedroomRGBLEDStripRainbowEffect(const std::string &name);
 };
 
 /// @brief Classe représentant le mode son-réaction d'un ruban de DEL RVB du système de domotique.
-class ConnectedBedroomRGBLEDStripSoundreactEffect : public light::LightEffect {
+class ConnectedBedroomRGBLEDStripSoundreactEffect : public ConnectedBedroomRGBLEDStripEffect {
  public:
   explicit ConnectedBedroomRGBLEDStripSoundreactEffect(const std::string &name);
-
-  void apply() override;
 };
 
 /// @brief Classe représentant le mode de l'alarme d'un ruban de DEL RVB du système de domotique.
-class ConnectedBedroomRGBLEDStripAlarmEffect : public light::LightEffect {
+class ConnectedBedroomRGBLEDStripAlarmEffect : public ConnectedBedroomRGBLEDStripEffect {
  public:
   explicit ConnectedBedroomRGBLEDStripAlarmEffect(const std::string &name);
-
-  void apply() override;
 };
 
 }  // namespace connected_bedroom
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace connected_bedroom {
+namespace protocol {
+
+/// @brief Familles de trames échangées avec l'Arduino Mega (premier caractère de la trame).
+enum FrameKinds : char {
+  FRAME_ORDER = '0',
+  FRAME_UPDATE = '1',
+  FRAME_MESSAGE = '2',
+  FRAME_CONTROL = '3',
+  FRAME_MUSIC = '4',
+  FRAME_MUSIC_PRESET = '5',
+  FRAME_DISPLAY = '6',
+  FRAME_CHUNK = '7',
+  FRAME_BATCH = '8',
+};
+
+/// @brief Valeur indiquant qu'une trame n'a pas de code ou pas de sous-code.
+static const int NO_CODE = -1;
+static const int NO_SUBCODE = -1;
+
+/// @brief Longueur de l'identifiant de communication des périphériques.
+static const uint8_t COMMUNICATION_ID_WIDTH = 2;
+
+/// @brief Longueur maximale d'une trame reçue par l'Arduino Mega, sans le retour à la ligne (taille de son tampon de
+/// réception).
+static const size_t MEGA_LINE_MAX_LENGTH = 60;
+
+// Calculs sur les largeurs des champs, évalués à la compilation.
+constexpr uint16_t sum_widths() { return 0; }
+template<typename... Rest> constexpr uint16_t sum_widths(uint8_t first, Rest... rest) {
+  return first + sum_widths(rest...);
+}
+
+constexpr uint8_t nth_width(uint8_t) { return 0; }
+template<typename... Rest> constexpr uint8_t nth_width(uint8_t index, uint8_t first, Rest... rest) {
+  return index == 0 ? first : nth_width(index - 1, rest...);
+}
+
+constexpr uint16_t widths_before(uint8_t) { return 0; }
+template<typename... Rest> constexpr uint16_t widths_before(uint8_t index, uint8_t first, Rest... rest) {
+  return index == 0 ? 0 : first + widths_before(index - 1, rest...);
+}
+
+constexpr bool valid_widths() { return true; }
+template<typename... Rest> constexpr bool valid_widths(uint8_t first, Rest... rest) {
+  return first >= 1 && first <= 9 && valid_widths(rest...);
+}
+
+/// @brief Lit un entier écrit en décimal dans une trame.
+/// @param frame La trame.
+/// @param position La position du premier chiffre.
+/// @param width Le nombre de chiffres.
+/// @return L'entier, ou `-1` si la trame est trop courte ou si un caractère n'est pas un chiffre.
+inline int32_t read_digits(const std::vector<uint8_t> &frame, size_t position, uint8_t width) {
+  if (position + width > frame.size())
+    return -1;
+
+  int32_t result = 0;
+  for (uint8_t i = 0; i < width; i++) {
+    uint8_t digit = frame[position + i] - '0';
+    if (digit > 9)
+      return -1;
+    result = result * 10 + digit;
+  }
+
+  return result;
+}
+
+/// @brief Ajoute un entier à une trame, sur une largeur fixe complétée de `0`. Une valeur trop grande est tronquée à
+/// ses chiffres de poids faible (une valeur négative est remplacée par `0`) pour ne jamais décaler les champs suivants.
+/// @param frame La trame.
+/// @param value L'entier.
+/// @param width Le nombre de chiffres.
+inline void append_digits(std::string &frame, int32_t value, uint8_t width) {
+  uint32_t remaining = value < 0 ? 0 : value;
+  char digits[9];
+  for (int i = width - 1; i >= 0; i--) {
+    digits[i] = char('0' + remaining % 10);
+    remaining /= 10;
+  }
+
+  frame.append(digits, width);
+}
+
+/// @brief Disposition des champs numériques d'une trame, qui suivent un en-tête de longueur fixe. Les positions et les
+/// largeurs sont calculées et vérifiées à la compilation.
+template<uint8_t HeaderLength, uint8_t... Widths> struct FieldLayout {
+  static_assert(valid_widths(Widths...), "each field must be 1 to 9 digits wide");
+
+  /// @brief Retourne la longueur minimale de la trame (sans le retour à la ligne final).
+  static constexpr uint16_t length() { return HeaderLength + sum_widths(Widths...); }
+
+  /// @brief Retourne la position d'un champ dans la trame.
+  static constexpr uint16_t offset(uint8_t index) { return HeaderLength + widths_before(index, Widths...); }
+
+  /// @brief Retourne la largeur d'un champ.
+  static constexpr uint8_t width(uint8_t index) { return nth_width(index, Widths...); }
+
+  /// @brief Lit un champ d'une trame reçue.
+  /// @return La valeur du champ, `-1` si elle est illisible.
+  template<uint8_t Index> static int32_t get(const std::vector<uint8_t> &frame) {
+    static_assert(Index < sizeof...(Widths), "this frame has no such field");
+    return read_digits(frame, offset(Index), width(Index));
+  }
+
+  /// @brief Ajoute les champs à une trame (une valeur par champ, vérifié à la compilation).
+  template<typename... Values> static void append(std::string &frame, Values... values) {
+    static_assert(sizeof...(Values) == sizeof...(Widths), "one value is expected for each field");
+    const int32_t values_array[] = {static_cast<int32_t>(values)..., 0};
+    const uint8_t widths_array[] = {Widths..., 0};
+    for (size_t i = 0; i < sizeof...(Widths); i++)
+      append_digits(frame, values_array[i], widths_array[i]);
+  }
+};
+
+/// @brief Trame concernant un périphérique : `KIICC[S]` (famille, identifiant de communication, code et sous-code
+/// éventuel) suivi des champs.
+template<char Kind, int Code, int Subcode, uint8_t... Widths>
+struct DeviceMessage : FieldLayout<(Subcode == NO_SUBCODE ? 5 : 6), Widths...> {
+  static_assert(Code >= 0 && Code <= 99, "the code is two digits wide");
+  static_assert(Subcode >= NO_SUBCODE && Subcode <= 9, "the subcode is a single digit");
+
+  using Layout = FieldLayout<(Subcode == NO_SUBCODE ? 5 : 6), Widths...>;
+
+  /// @brief Construit la trame destinée à un périphérique.
+  template<typename... Values> static std::string encode(int communication_id, Values... values) {
+    std::string frame;
+    frame.reserve(Layout::length());
+    frame.push_back(Kind);
+    append_digits(frame, communication_id, COMMUNICATION_ID_WIDTH);
+    append_digits(frame, Code, 2);
+    if (Subcode != NO_SUBCODE)
+      frame.push_back(char('0' + Subcode));
+    Layout::append(frame, values...);
+    return frame;
+  }
+
+  /// @brief Indique si une trame reçue est de ce type (et assez longue pour en lire tous les champs).
+  static bool matches(const std::vector<uint8_t> &frame) {
+    return frame.size() >= Layout::length() && frame[0] == Kind && read_digits(frame, 3, 2) == Code &&
+           (Subcode == NO_SUBCODE || frame[5] == '0' + Subcode);
+  }
+
+  /// @brief Retourne l'identifiant de communication d'une trame reçue.
+  static int communication_id(const std::vector<uint8_t> &frame) {
+    return read_digits(frame, 1, COMMUNICATION_ID_WIDTH);
+  }
+};
+
+/// @brief Trame ne concernant pas un périphérique : `K[CC]` (famille et code éventuel) suivi des champs.
+template<char Kind, int Code, uint8_t... Widths> struct Message : FieldLayout<(Code == NO_CODE ? 1 : 3), Widths...> {
+  static_assert(Code >= NO_CODE && Code <= 99, "the code is two digits wide");
+
+  using Layout = FieldLayout<(Code == NO_CODE ? 1 : 3), Widths...>;
+
+  /// @brief Construit la trame (les données de longueur variable sont ajoutées à la suite par l'appelant).
+  template<typename... Values> static std::string encode(Values... values) {
+    std::string frame;
+    frame.reserve(Layout::length());
+    frame.push_back(Kind);
+    if (Code != NO_CODE)
+      append_digits(frame, Code, 2);
+    Layout::append(frame, values...);
+    return frame;
+  }
+
+  /// @brief Indique si une trame reçue est de ce type (et assez longue pour en lire tous les champs).
+  static bool matches(const std::vector<uint8_t> &frame) {
+    return frame.size() >= Layout::length() && frame[0] == Kind &&
+           (Code == NO_CODE || read_digits(frame, 1, 2) == Code);
+  }
+};
+
+/// @brief Valeurs du champ des ordres de l'alarme (`0II02X`).
+enum AlarmOrders : uint8_t { ALARM_RESET, ALARM_TRIGGER };
+
+/// @brief Valeurs du champ des ordres de la télévision (`0II03X`).
+enum TelevisionOrders : uint8_t { TELEVISION_VOLUME_DOWN, TELEVISION_VOLUME_UP, TELEVISION_MUTE, TELEVISION_UNMUTE };
+
+// Ordres envoyés à l'Arduino Mega.
+using OrderPower = DeviceMessage<FRAME_ORDER, 0, NO_SUBCODE, 1>;
+using OrderRGBLEDStripEffect = DeviceMessage<FRAME_ORDER, 1, NO_SUBCODE, 1>;
+using OrderRGBLEDStripColor = DeviceMessage<FRAME_ORDER, 1, 0, 3, 3, 3>;
+using OrderRGBLEDStripTransition = DeviceMessage<FRAME_ORDER, 1, 4, 3, 3, 3, 3, 3, 3, 5, 1>;
+using OrderRGBLEDStripEffectParameters = DeviceMessage<FRAME_ORDER, 1, 5, 1, 3, 3, 3, 3>;
+using OrderAlarm = DeviceMessage<FRAME_ORDER, 2, NO_SUBCODE, 1>;
+using OrderMissileLaunch = DeviceMessage<FRAME_ORDER, 2, 4>;
+using OrderMissileLauncherAim = DeviceMessage<FRAME_ORDER, 2, 5, 3, 3>;
+using OrderTelevision = DeviceMessage<FRAME_ORDER, 3, NO_SUBCODE, 1>;
+using OrderTelevisionVolume = DeviceMessage<FRAME_ORDER, 3, 4, 2>;
+using OrderPixels = DeviceMessage<FRAME_ORDER, 5, 0>;
+using OrderPixelsShow = DeviceMessage<FRAME_ORDER, 5, 1>;
+
+// Ordres de l'Arduino Mega destinés aux périphériques connectés de Home Assistant.
+using OrderConnectedDevicePower = DeviceMessage<FRAME_ORDER, 0, NO_SUBCODE, 1>;
+using OrderTemperatureLightTemperature = DeviceMessage<FRAME_ORDER, 4, 0, 4>;
+using OrderTemperatureLightBrightness = DeviceMessage<FRAME_ORDER, 4, 1, 3>;
+using OrderColorLightColor = DeviceMessage<FRAME_ORDER, 5, 0, 3, 3, 3>;
+using OrderColorLightTemperature = DeviceMessage<FRAME_ORDER, 5, 1, 4>;
+using OrderColorLightBrightness = DeviceMessage<FRAME_ORDER, 5, 2, 3>;
+
+// Mises à jour envoyées par l'Arduino Mega.
+using UpdatePower = DeviceMessage<FRAME_UPDATE, 1, NO_SUBCODE, 1>;
+using UpdateRGBLEDStripColor = DeviceMessage<FRAME_UPDATE, 2, 0, 3, 3, 3>;
+using UpdateRGBLEDStripEffect = DeviceMessage<FRAME_UPDATE, 2, NO_SUBCODE, 1>;
+using UpdateAlarmArmed = DeviceMessage<FRAME_UPDATE, 3, 0>;
+using UpdateAlarmTriggered = DeviceMessage<FRAME_UPDATE, 3, 1>;
+using UpdateMissileLauncherBase = DeviceMessage<FRAME_UPDATE, 3, 2, 3>;
+using UpdateMissileLauncherAngle = DeviceMessage<FRAME_UPDATE, 3, 3, 3>;
+using UpdateMissileLauncherMissiles = DeviceMessage<FRAME_UPDATE, 3, 4, 1, 1, 1>;
+using UpdateMissileLauncherAim = DeviceMessage<FRAME_UPDATE, 3, 5, 3, 3>;
+using UpdateTelevisionVolume = DeviceMessage<FRAME_UPDATE, 4, 0, 2>;
+using UpdateTelevisionMuted = DeviceMessage<FRAME_UPDATE, 4, 1>;
+using UpdateTelevisionUnmuted = DeviceMessage<FRAME_UPDATE, 4, 2>;
+using UpdateBinarySensor = DeviceMessage<FRAME_UPDATE, 7, NO_SUBCODE, 1>;
+using UpdateAnalogSensor = DeviceMessage<FRAME_UPDATE, 8, NO_SUBCODE, 4>;
+using UpdateTemperatureSensor = DeviceMessage<FRAME_UPDATE, 9, NO_SUBCODE, 4, 4>;
+using UpdateMultiValueSensor = DeviceMessage<FRAME_UPDATE, 10, NO_SUBCODE, 1>;
+
+// Mises à jour des périphériques connectés de Home Assistant, envoyées à l'Arduino Mega.
+using UpdateConnectedDevicePower = DeviceMessage<FRAME_UPDATE, 1, NO_SUBCODE, 1>;
+using UpdateTemperatureLightTemperature = DeviceMessage<FRAME_UPDATE, 5, 2, 4>;
+using UpdateTemperatureLightBrightness = DeviceMessage<FRAME_UPDATE, 5, 3, 3>;
+using UpdateColorLightColor = DeviceMessage<FRAME_UPDATE, 6, 2, 3, 3, 3>;
+using UpdateColorLightTemperature = DeviceMessage<FRAME_UPDATE, 6, 3, 4>;
+using UpdateColorLightBrightness = DeviceMessage<FRAME_UPDATE, 6, 4, 3>;
+
+/// @brief Valeur d'un capteur à plusieurs valeurs : signe (`+` ou `-`) suivi de 5 chiffres.
+static const uint8_t SENSOR_VALUE_WIDTH = 6;
+
+// Messages, musique et affichage (suivis de données de longueur variable). `TextMessage` est utilisé dans les deux
+// sens : message à prononcer reçu de l'Arduino Mega, et texte `titre/message` à afficher envoyé à celui-ci.
+using TextMessage = Message<FRAME_MESSAGE, NO_CODE>;
+using MusicURL = Message<FRAME_MUSIC, NO_CODE>;
+using MusicPreset = Message<FRAME_MUSIC_PRESET, NO_CODE, 3>;
+using DisplayMessage = Message<FRAME_DISPLAY, NO_CODE>;
+using Chunk = Message<FRAME_CHUNK, NO_CODE, 2, 2>;
+static const uint8_t MAX_CHUNK_PAYLOAD = MEGA_LINE_MAX_LENGTH - Chunk::length();
+
+// Synchronisation, alimentation et surveillance de la liaison. Le code `301` est utilisé dans les deux sens :
+// `ControlSynchronization` est la demande de synchronisation reçue de l'Arduino Mega (`301`), et
+// `ControlDeltaSynchronization` la demande de synchronisation différentielle envoyée à celui-ci (`301EEE...`).
+using ControlFullSynchronization = Message<FRAME_CONTROL, 0>;
+using ControlSynchronization = Message<FRAME_CONTROL, 1>;
+using ControlDeltaSynchronization = Message<FRAME_CONTROL, 1, 3>;
+using ControlShutdown = Message<FRAME_CONTROL, 2, 1>;
+using ControlEpoch = Message<FRAME_CONTROL, 3, 3>;
+using ControlAcknowledgement = Message<FRAME_CONTROL, 4, 2>;
+using ControlPing = Message<FRAME_CONTROL, 5, 3>;
+using ControlPoll = Message<FRAME_CONTROL, 6>;
+using ControlChunkCredit = Message<FRAME_CONTROL, 7, 2>;
+using ControlDeltaSynchronizationPart = Message<FRAME_CONTROL, 8, 3>;
+
+/// @brief Trame regroupant plusieurs trames de périphériques : `8NN` (nombre d'enregistrements) puis, pour chaque
+/// enregistrement, sa longueur et la trame (`LL1IICC...`, avec son éventuelle version `#VVV`).
+using Batch = Message<FRAME_BATCH, NO_CODE, 2>;
+using BatchRecordLength = FieldLayout<0, 2>;
+static const uint8_t MAX_BATCH_RECORDS = 99;
+
+/// @brief Version d'un périphérique dans une demande de synchronisation différentielle (identifiant puis version).
+using DeviceVersionRecord = FieldLayout<0, COMMUNICATION_ID_WIDTH, 3>;
+static const uint8_t DEVICE_VERSION_RECORDS_PER_FRAME =
+    (MEGA_LINE_MAX_LENGTH - ControlDeltaSynchronization::length()) / DeviceVersionRecord::length();
+
+/// @brief Durée maximale d'une transition d'un ruban de DEL RVB en millisecondes (champ de 5 chiffres).
+static const uint32_t MAX_TRANSITION_LENGTH = 99999;
+
+/// @brief Version de l'état d'un périphérique, ajoutée à la fin d'une mise à jour (`#VVV`).
+static const char VERSION_SEPARATOR = '#';
+static const uint8_t VERSION_WIDTH = 3;
+
+/// @brief Numéro de séquence d'une trame critique, ajouté à la fin de celle-ci (`*SS`).
+static const char SEQUENCE_SEPARATOR = '*';
+static const uint8_t SEQUENCE_WIDTH = 2;
+
+static_assert(MusicPreset::length() + 1 == 5, "starting a music preset must cost a 5-byte frame");
+static_assert(OrderRGBLEDStripTransition::length() == 30, "the transition frame layout is shared with the Mega");
+static_assert(MAX_CHUNK_PAYLOAD == 55, "the chunk size limit is mirrored in the component's configuration schema");
+static_assert(MAX_TRANSITION_LENGTH == 99999, "the transition length limit is mirrored in the configuration schema");
+
+}  // namespace protocol
+}  // namespace connected_bedroom
+}  // namespace esphome
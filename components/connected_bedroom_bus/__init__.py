@@ -0,0 +1,43 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome import pins
+from esphome.components import uart
+from esphome.const import CONF_ID, CONF_FLOW_CONTROL_PIN
+
+CODEOWNERS = ["@zetiti10"]
+
+MULTI_CONF = True
+DEPENDENCIES = ['uart', 'connected_bedroom']
+
+connected_bedroom_bus_ns = cg.esphome_ns.namespace('connected_bedroom_bus')
+
+ConnectedBedroomBus = connected_bedroom_bus_ns.class_('ConnectedBedroomBus', cg.Component, uart.UARTDevice)
+ConnectedBedroomBusNode = connected_bedroom_bus_ns.class_('ConnectedBedroomBusNode', uart.UARTComponent)
+
+CONF_CONNECTED_BEDROOM_BUS_ID = "connected_bedroom_bus_id"
+CONF_POLL_INTERVAL = "poll_interval"
+CONF_RESPONSE_TIMEOUT = "response_timeout"
+CONF_STATISTICS_INTERVAL = "statistics_interval"
+
+CONFIG_SCHEMA = uart.UART_DEVICE_SCHEMA.extend(
+    {
+        cv.GenerateID(): cv.declare_id(ConnectedBedroomBus),
+        cv.Optional(CONF_FLOW_CONTROL_PIN): pins.gpio_output_pin_schema,
+        cv.Optional(CONF_POLL_INTERVAL, default="20ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_RESPONSE_TIMEOUT, default="50ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_STATISTICS_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    await uart.register_uart_device(var, config)
+    cg.add(var.set_poll_interval(config[CONF_POLL_INTERVAL]))
+    cg.add(var.set_response_timeout(config[CONF_RESPONSE_TIMEOUT]))
+    cg.add(var.set_statistics_interval(config[CONF_STATISTICS_INTERVAL]))
+
+    if CONF_FLOW_CONTROL_PIN in config:
+        flow_control_pin = await cg.gpio_pin_expression(config[CONF_FLOW_CONTROL_PIN])
+        cg.add(var.set_flow_control_pin(flow_control_pin))
@@ -0,0 +1,301 @@
+/**
+ * @file esphome/components/connected_bedroom_bus/connected_bedroom_bus.cpp
+ * @author Louis L
+ * @brief Bus reliant l'ESP8266 à plusieurs microcontrôleurs du système de domotique.
+ * @version 2.0 dev
+ * @date 2024-01-20
+ */
+
+// Ajout des bibilothèques au programme.
+#include <algorithm>
+#include <cctype>
+
+// Autres fichiers du programme.
+#include "connected_bedroom_bus.h"
+#include "esphome/components/connected_bedroom/protocol.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace connected_bedroom_bus {
+
+static const char *TAG = "connected_bedroom_bus";
+
+// Trame de passage de la parole (`protocol::ControlPoll`) : demandée par l'ESP8266, renvoyée par le microcontrôleur à
+// la fin de son tour.
+using connected_bedroom::protocol::ControlPoll;
+
+/// @brief Définit l'adresse du microcontrôleur sur le bus.
+/// @param address L'adresse (deux chiffres).
+void ConnectedBedroomBusNode::set_address(uint8_t address) { this->address_ = address; }
+
+/// @brief Retourne l'adresse du microcontrôleur sur le bus.
+/// @return L'adresse.
+uint8_t ConnectedBedroomBusNode::get_address() const { return this->address_; }
+
+/// @brief Écrit des octets vers le microcontrôleur : chaque ligne complète attend que le bus soit libre.
+/// @param data Les octets.
+/// @param len Le nombre d'octets.
+void ConnectedBedroomBusNode::write_array(const uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] == '\n') {
+      this->tx_frames_.push_back(this->tx_line_);
+      this->tx_line_.clear();
+    } else {
+      this->tx_line_.push_back(char(data[i]));
+    }
+  }
+}
+
+/// @brief Lit le prochain octet reçu du microcontrôleur sans le retirer.
+/// @param data L'octet lu.
+/// @return `false` si aucun octet n'est disponible.
+bool ConnectedBedroomBusNode::peek_byte(uint8_t *data) {
+  if (this->rx_position_ >= this->rx_buffer_.size())
+    return false;
+
+  *data = this->rx_buffer_[this->rx_position_];
+  return true;
+}
+
+/// @brief Lit des octets reçus du microcontrôleur.
+/// @param data Les octets lus.
+/// @param len Le nombre d'octets à lire.
+/// @return `false` si moins de `len` octets sont disponibles (rien n'est alors lu).
+bool ConnectedBedroomBusNode::read_array(uint8_t *data, size_t len) {
+  if (this->rx_buffer_.size() - this->rx_position_ < len)
+    return false;
+
+  std::copy(this->rx_buffer_.begin() + this->rx_position_, this->rx_buffer_.begin() + this->rx_position_ + len, data);
+  this->rx_position_ += len;
+
+  if (this->rx_position_ == this->rx_buffer_.size()) {
+    this->rx_buffer_.clear();
+    this->rx_position_ = 0;
+  }
+
+  return true;
+}
+
+/// @brief Retourne le nombre d'octets reçus du microcontrôleur et pas encore lus.
+/// @return Le nombre d'octets.
+int ConnectedBedroomBusNode::available() { return this->rx_buffer_.size() - this->rx_position_; }
+
+/// @brief Les trames sont émises par le bus depuis sa boucle : il n'y a rien à attendre ici.
+void ConnectedBedroomBusNode::flush() {}
+
+/// @brief Méthode permettant d'obtenir la priorité d'initialisation du bus (avant les composants qui l'utilisent).
+/// @return La priorité d'initialisation du bus.
+float ConnectedBedroomBus::get_setup_priority() const { return setup_priority::BUS; }
+
+/// @brief Méthode d'initialisation du bus.
+void ConnectedBedroomBus::setup() {
+  if (this->flow_control_pin_ != nullptr) {
+    this->flow_control_pin_->setup();
+    this->flow_control_pin_->digital_write(false);
+  }
+
+  // Les liaisons virtuelles ont le débit du bus (utilisé pour rythmer les envois).
+  for (auto node : this->nodes_)
+    node->set_baud_rate(this->parent_->get_baud_rate());
+
+  this->last_statistics_ = millis();
+}
+
+/// @brief Méthode exécutée en boucle : réception, envoi des trames en attente et interrogation des microcontrôleurs.
+void ConnectedBedroomBus::loop() {
+  // Lecture des lignes reçues, transmises au microcontrôleur correspondant à leur adresse.
+  while (this->available()) {
+    uint8_t letter = this->read();
+
+    if (letter == '\r')
+      continue;
+
+    if (letter == '\n') {
+      this->receive_line_();
+      this->rx_line_.clear();
+    }
+
+    else if (this->rx_line_.size() < MAX_BUS_LINE_LENGTH)
+      this->rx_line_.push_back(letter);
+  }
+
+  uint32_t now = millis();
+
+  // Un microcontrôleur a la parole : personne d'autre ne peut émettre.
+  if (this->polled_node_ != nullptr) {
+    if (now - this->polled_at_ < this->response_timeout_)
+      return;
+
+    this->end_turn_(false);
+  }
+
+  this->send_pending_frames_();
+
+  if (!this->nodes_.empty() && now - this->last_poll_ >= this->poll_interval_)
+    this->poll_next_node_();
+
+  if (this->statistics_interval_ > 0 && now - this->last_statistics_ >= this->statistics_interval_)
+    this->log_statistics_();
+}
+
+/// @brief Méthode permettant d'afficher la configuration du bus.
+void ConnectedBedroomBus::dump_config() {
+  ESP_LOGCONFIG(TAG, "Connected bedroom bus");
+  LOG_PIN("  Flow control pin: ", this->flow_control_pin_);
+  ESP_LOGCONFIG(TAG, "  Poll interval: %u ms", this->poll_interval_);
+  ESP_LOGCONFIG(TAG, "  Response timeout: %u ms", this->response_timeout_);
+  ESP_LOGCONFIG(TAG, "  Nodes:");
+  for (auto node : this->nodes_)
+    ESP_LOGCONFIG(TAG, "    Address: %02u", node->address_);
+}
+
+/// @brief Ajoute un microcontrôleur au bus.
+/// @param node La liaison virtuelle vers le microcontrôleur.
+void ConnectedBedroomBus::add_node(ConnectedBedroomBusNode *node) { this->nodes_.push_back(node); }
+
+/// @brief Définit la broche activant l'émetteur du bus (broche DE d'un émetteur-récepteur RS-485).
+/// @param flow_control_pin La broche.
+void ConnectedBedroomBus::set_flow_control_pin(GPIOPin *flow_control_pin) {
+  this->flow_control_pin_ = flow_control_pin;
+}
+
+/// @brief Définit la durée entre deux interrogations de microcontrôleurs.
+/// @param poll_interval La durée en millisecondes.
+void ConnectedBedroomBus::set_poll_interval(uint32_t poll_interval) { this->poll_interval_ = poll_interval; }
+
+/// @brief Définit le délai après lequel un microcontrôleur interrogé perd la parole.
+/// @param response_timeout Le délai en millisecondes.
+void ConnectedBedroomBus::set_response_timeout(uint32_t response_timeout) {
+  this->response_timeout_ = response_timeout;
+}
+
+/// @brief Définit la durée entre deux rapports de débit et de latence de chaque microcontrôleur.
+/// @param statistics_interval La durée en millisecondes (`0` pour désactiver les rapports).
+void ConnectedBedroomBus::set_statistics_interval(uint32_t statistics_interval) {
+  this->statistics_interval_ = statistics_interval;
+}
+
+/// @brief Traite une ligne reçue (`@NN...`) : fin du tour de parole ou trame à transmettre au microcontrôleur `NN`.
+void ConnectedBedroomBus::receive_line_() {
+  if (this->rx_line_.size() < 3 || this->rx_line_[0] != '@' || !isdigit(this->rx_line_[1]) ||
+      !isdigit(this->rx_line_[2])) {
+    ESP_LOGV(TAG, "Line without address ignored.");
+    return;
+  }
+
+  uint8_t address = (this->rx_line_[1] - '0') * 10 + (this->rx_line_[2] - '0');
+  ConnectedBedroomBusNode *node = this->get_node_(address);
+  if (node == nullptr) {
+    ESP_LOGV(TAG, "Line from unknown address %02u ignored.", address);
+    return;
+  }
+
+  // L'adresse retirée, la ligne est la trame destinée au microcontrôleur.
+  this->rx_line_.erase(this->rx_line_.begin(), this->rx_line_.begin() + 3);
+
+  if (node == this->polled_node_ && this->rx_line_.size() == ControlPoll::length() &&
+      ControlPoll::matches(this->rx_line_)) {
+    this->end_turn_(true);
+    return;
+  }
+
+  node->rx_buffer_.insert(node->rx_buffer_.end(), this->rx_line_.begin(), this->rx_line_.end());
+  node->rx_buffer_.push_back('\n');
+  node->statistics_.rx_frames++;
+  node->statistics_.rx_bytes += 3 + this->rx_line_.size() + 1;  // Adresse `@NN` et retour à la ligne compris.
+}
+
+/// @brief Émet des octets sur le bus, en activant l'émetteur le temps de l'émission si une broche est configurée.
+/// @param data Les octets.
+void ConnectedBedroomBus::transmit_(const std::string &data) {
+  if (this->flow_control_pin_ != nullptr)
+    this->flow_control_pin_->digital_write(true);
+
+  this->write_str(data.c_str());
+
+  if (this->flow_control_pin_ != nullptr) {
+    this->flush();
+    this->flow_control_pin_->digital_write(false);
+  }
+}
+
+/// @brief Émet, en une fois, les trames en attente de tous les microcontrôleurs (le bus est libre).
+void ConnectedBedroomBus::send_pending_frames_() {
+  std::string data;
+  for (auto node : this->nodes_) {
+    std::string address = "@" + str_sprintf("%02u", node->address_);
+    for (auto &frame : node->tx_frames_) {
+      data += address + frame + "\n";
+      node->statistics_.tx_frames++;
+      node->statistics_.tx_bytes += address.size() + frame.size() + 1;
+    }
+    node->tx_frames_.clear();
+  }
+
+  if (!data.empty())
+    this->transmit_(data);
+}
+
+/// @brief Donne la parole au microcontrôleur suivant.
+void ConnectedBedroomBus::poll_next_node_() {
+  this->next_node_ %= this->nodes_.size();
+  ConnectedBedroomBusNode *node = this->nodes_[this->next_node_++];
+
+  this->transmit_("@" + str_sprintf("%02u", node->address_) + ControlPoll::encode() + "\n");
+  node->statistics_.polls++;
+
+  this->polled_node_ = node;
+  this->polled_at_ = millis();
+  this->last_poll_ = this->polled_at_;
+}
+
+/// @brief Termine le tour de parole du microcontrôleur interrogé.
+/// @param answered `true` si le microcontrôleur a rendu la parole, `false` si le délai de réponse est écoulé.
+void ConnectedBedroomBus::end_turn_(bool answered) {
+  NodeStatistics &statistics = this->polled_node_->statistics_;
+  if (answered) {
+    uint32_t latency = millis() - this->polled_at_;
+    statistics.answers++;
+    statistics.latency_sum += latency;
+    statistics.latency_max = std::max(statistics.latency_max, latency);
+  } else {
+    statistics.timeouts++;
+  }
+
+  this->polled_node_ = nullptr;
+}
+
+/// @brief Affiche le débit et la latence de chaque microcontrôleur depuis le rapport précédent.
+void ConnectedBedroomBus::log_statistics_() {
+  uint32_t now = millis();
+  float seconds = std::max<uint32_t>(now - this->last_statistics_, 1) / 1000.0f;
+  this->last_statistics_ = now;
+
+  for (auto node : this->nodes_) {
+    NodeStatistics &statistics = node->statistics_;
+    ESP_LOGI(TAG,
+             "Node %02u: rx %u frames (%.1f B/s), tx %u frames (%.1f B/s), %u polls, latency avg %u ms max %u ms, "
+             "%u timeouts",
+             node->address_, statistics.rx_frames, statistics.rx_bytes / seconds, statistics.tx_frames,
+             statistics.tx_bytes / seconds, statistics.polls,
+             statistics.answers > 0 ? statistics.latency_sum / statistics.answers : 0, statistics.latency_max,
+             statistics.timeouts);
+    statistics = NodeStatistics{};
+  }
+}
+
+/// @brief Retourne le microcontrôleur correspondant à une adresse.
+/// @param address L'adresse.
+/// @return Le microcontrôleur, `nullptr` s'il n'existe pas.
+ConnectedBedroomBusNode *ConnectedBedroomBus::get_node_(uint8_t address) const {
+  for (auto node : this->nodes_) {
+    if (node->address_ == address)
+      return node;
+  }
+
+  return nullptr;
+}
+
+}  // namespace connected_bedroom_bus
+}  // namespace esphome
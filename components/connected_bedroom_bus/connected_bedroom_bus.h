@@ -0,0 +1,103 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/components/uart/uart.h"
+
+namespace esphome {
+namespace connected_bedroom_bus {
+
+/// @brief Longueur maximale d'une ligne reçue sur le bus (au-delà, la ligne est tronquée).
+static const uint16_t MAX_BUS_LINE_LENGTH = 512;
+
+class ConnectedBedroomBus;
+
+/// @brief Statistiques d'un microcontrôleur du bus, pour dimensionner celui-ci (remises à zéro à chaque rapport).
+struct NodeStatistics {
+  uint32_t rx_frames;
+  uint32_t rx_bytes;
+  uint32_t tx_frames;
+  uint32_t tx_bytes;
+  uint32_t polls;
+  uint32_t answers;
+  uint32_t timeouts;
+  uint32_t latency_sum;
+  uint32_t latency_max;
+};
+
+/// @brief Liaison UART virtuelle vers un microcontrôleur du bus. Le composant `connected_bedroom` l'utilise comme une
+/// liaison point à point : le bus ajoute l'adresse du microcontrôleur (`@NN`) aux trames émises et ne lui transmet que
+/// les trames qui lui sont adressées.
+class ConnectedBedroomBusNode : public uart::UARTComponent {
+ public:
+  void set_address(uint8_t address);
+  uint8_t get_address() const;
+
+  void write_array(const uint8_t *data, size_t len) override;
+  bool peek_byte(uint8_t *data) override;
+  bool read_array(uint8_t *data, size_t len) override;
+  int available() override;
+  void flush() override;
+
+ protected:
+  friend class ConnectedBedroomBus;
+
+  void check_logger_conflict() override {}
+
+  uint8_t address_{0};
+
+  // Octets reçus par le bus pour ce microcontrôleur, lus par le composant `connected_bedroom`.
+  std::vector<uint8_t> rx_buffer_;
+  size_t rx_position_{0};
+
+  // Trames écrites par le composant `connected_bedroom`, en attente d'un moment où le bus est libre.
+  std::string tx_line_;
+  std::vector<std::string> tx_frames_;
+
+  NodeStatistics statistics_{};
+};
+
+/// @brief Bus semi-duplex (RS-485 par exemple) reliant l'ESP8266 à plusieurs microcontrôleurs. L'ESP8266 est le
+/// maître : il interroge les microcontrôleurs à tour de rôle (`@NN306`), et seul le microcontrôleur interrogé peut
+/// émettre, jusqu'à ce qu'il rende la parole (`@NN306`) ou que le délai de réponse soit écoulé.
+class ConnectedBedroomBus : public Component, public uart::UARTDevice {
+ public:
+  float get_setup_priority() const override;
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+
+  // Méthodes permettant de configurer le bus.
+  void add_node(ConnectedBedroomBusNode *node);
+  void set_flow_control_pin(GPIOPin *flow_control_pin);
+  void set_poll_interval(uint32_t poll_interval);
+  void set_response_timeout(uint32_t response_timeout);
+  void set_statistics_interval(uint32_t statistics_interval);
+
+ protected:
+  void receive_line_();
+  void transmit_(const std::string &data);
+  void send_pending_frames_();
+  void poll_next_node_();
+  void end_turn_(bool answered);
+  void log_statistics_();
+  ConnectedBedroomBusNode *get_node_(uint8_t address) const;
+
+  std::vector<ConnectedBedroomBusNode *> nodes_;
+  GPIOPin *flow_control_pin_{nullptr};
+  uint32_t poll_interval_{20};
+  uint32_t response_timeout_{50};
+  uint32_t statistics_interval_{60000};
+
+  std::vector<uint8_t> rx_line_;
+
+  // Microcontrôleur ayant la parole (`nullptr` si le bus est libre).
+  ConnectedBedroomBusNode *polled_node_{nullptr};
+  uint32_t polled_at_{0};
+  size_t next_node_{0};
+  uint32_t last_poll_{0};
+  uint32_t last_statistics_{0};
+};
+
+}  // namespace connected_bedroom_bus
+}  // namespace esphome
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""Remplaçant de Home Assistant pour les tests d'endurance du composant `connected_bedroom`.
+
+L'outil se connecte à l'API native de l'ESP8266 (comme le ferait Home Assistant) et :
+
+- répond aux abonnements du composant (`subscribe_homeassistant_state`) en rejouant des rafales de changements d'état
+  scénarisées pour toutes les entités des ampoules connectées (`connected_lights`) : état, luminosité, température de
+  couleur et couleur ;
+- enregistre chaque appel de service Home Assistant émis par le composant, avec son instant (`--record`, JSON lines) ;
+- si les services de test d'endurance sont compilés (`soak_test_services: true`), injecte des ordres de l'Arduino Mega
+  (`inject_frame`) pour mesurer la latence jusqu'à l'appel de service correspondant, et lit les compteurs du composant
+  (`dump_link_statistics`) pour calculer les fonctions de rappel par seconde et les octets UART émis par changement.
+
+Dépendance : `pip install aioesphomeapi`.
+
+Exemple :
+    tools/ha_soak_test.py chambre.local --password secret --rate 50 --duration 60 --record calls.jsonl
+
+Avec `--address`, l'outil utilise les services du microcontrôleur d'un bus partagé (`connected_bedroom_bus`) dont
+l'adresse est donnée : leur nom est suivi de `_NN`.
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import re
+import statistics
+import sys
+import time
+
+try:
+    from aioesphomeapi import APIClient
+except ImportError:
+    sys.exit("aioesphomeapi is required: pip install aioesphomeapi")
+
+STATISTICS_PATTERN = re.compile(r"link statistics: (.*)$")
+
+
+class SoakTest:
+    def __init__(self, args):
+        self.args = args
+        self.client = APIClient(args.host, args.port, args.password, noise_psk=args.encryption_key)
+        self.subscriptions = []
+        self.service_calls = []
+        self.pending_orders = {}
+        self.latencies = []
+        self.link_statistics = []
+        self.changes_sent = 0
+        self.services = {}
+        self.record = open(args.record, "w", encoding="utf-8") if args.record else None
+
+    # Abonnements du composant aux états de Home Assistant.
+    def on_state_subscription(self, entity_id, attribute):
+        self.subscriptions.append((entity_id, attribute))
+
+    def random_state(self, attribute):
+        if not attribute:
+            return random.choice(("on", "off"))
+        if attribute == "brightness":
+            return str(random.randint(0, 255))
+        if attribute == "color_temp_kelvin":
+            return str(random.randint(2000, 6500))
+        if attribute == "rgb_color":
+            return str(tuple(random.randint(0, 255) for _ in range(3)))
+        return "None"
+
+    def send_state(self, entity_id, attribute):
+        self.client.send_home_assistant_state(entity_id, attribute, self.random_state(attribute))
+        self.changes_sent += 1
+
+    # Appels de services Home Assistant émis par le composant.
+    def on_service_call(self, call):
+        now = time.monotonic()
+        data = dict(call.data)
+        entry = {"time": now, "service": call.service, "data": data}
+        self.service_calls.append(entry)
+        if self.record:
+            self.record.write(json.dumps(entry) + "\n")
+
+        entity_id = data.get("entity_id") or data.get("light")
+        sent_at = self.pending_orders.pop(entity_id, None)
+        if sent_at is not None:
+            self.latencies.append((now - sent_at) * 1000)
+
+    def on_log(self, message):
+        text = message.message
+        if isinstance(text, bytes):
+            text = text.decode("utf-8", errors="replace")
+        match = STATISTICS_PATTERN.search(text)
+        if match:
+            values = dict(item.split("=") for item in match.group(1).split())
+            self.link_statistics.append({key: int(value) for key, value in values.items()})
+
+    def service_name(self, name):
+        return name if self.args.address is None else f"{name}_{self.args.address:02d}"
+
+    async def execute(self, name, **data):
+        service = self.services.get(self.service_name(name))
+        if service is None:
+            return False
+        result = self.client.execute_service(service, data)
+        if asyncio.iscoroutine(result):
+            await result
+        return True
+
+    async def inject_orders(self, lights):
+        """Injecte un ordre de l'Arduino Mega pour une ampoule connectée et note l'instant pour mesurer la latence."""
+        for communication_id, entity_id in lights:
+            self.pending_orders[entity_id] = time.monotonic()
+            await self.execute("inject_frame", frame="0" + str(communication_id).zfill(2) + "002")
+
+    async def run(self):
+        await self.client.connect(login=True)
+        _, services = await self.client.list_entities_services()
+        self.services = {service.name: service for service in services}
+
+        subscribe_states = self.client.subscribe_home_assistant_states
+        subscribe_services = getattr(self.client, "subscribe_service_calls", None) or getattr(
+            self.client, "subscribe_homeassistant_services"
+        )
+        result = subscribe_states(self.on_state_subscription)
+        if asyncio.iscoroutine(result):
+            await result
+        result = subscribe_services(self.on_service_call)
+        if asyncio.iscoroutine(result):
+            await result
+        result = self.client.subscribe_logs(self.on_log)
+        if asyncio.iscoroutine(result):
+            await result
+
+        await asyncio.sleep(self.args.settle)
+        entity_ids = sorted({entity_id for entity_id, _ in self.subscriptions})
+        print(f"{len(entity_ids)} connected light entities, {len(self.subscriptions)} subscriptions.")
+        if not self.subscriptions:
+            sys.exit("the device did not subscribe to any Home Assistant state")
+
+        lights = [(int(light.split(":")[0]), light.split(":", 1)[1]) for light in self.args.light]
+        soak_services = self.service_name("dump_link_statistics") in self.services
+        if not soak_services:
+            print("soak_test_services is not enabled: device counters and order latency are unavailable.")
+        elif not lights:
+            print("no --light given: order latency is not measured.")
+
+        await self.execute("reset_link_statistics")
+        start = time.monotonic()
+        next_report = start + 1.0
+        next_order = start
+        interval = 1.0 / self.args.rate
+        sent_in_burst = 0
+
+        while time.monotonic() - start < self.args.duration:
+            # Rafales : `--burst` changements envoyés d'un coup, puis une pause pour revenir au débit moyen.
+            self.send_state(*random.choice(self.subscriptions))
+            sent_in_burst += 1
+            if sent_in_burst >= self.args.burst:
+                sent_in_burst = 0
+                await asyncio.sleep(interval * self.args.burst)
+
+            now = time.monotonic()
+            if soak_services and lights and self.args.order_interval > 0 and now >= next_order:
+                next_order = now + self.args.order_interval
+                await self.inject_orders(random.sample(lights, min(len(lights), self.args.orders_per_round)))
+
+            if now >= next_report:
+                next_report += 1.0
+                await self.execute("dump_link_statistics")
+                self.report(now - start)
+
+        await asyncio.sleep(self.args.settle)
+        await self.execute("dump_link_statistics")
+        await asyncio.sleep(0.5)
+        self.report(time.monotonic() - start, final=True)
+        await self.client.disconnect()
+
+    def report(self, elapsed, final=False):
+        line = f"{elapsed:8.1f} s  changes {self.changes_sent:7}  service calls {len(self.service_calls):6}"
+
+        if len(self.link_statistics) >= 2:
+            first, last = self.link_statistics[0], self.link_statistics[-1]
+            duration = max(last["uptime"] - first["uptime"], 1) / 1000
+            callbacks = last["ha_callbacks"] - first["ha_callbacks"]
+            line += f"  callbacks/s {callbacks / duration:7.1f}"
+            if callbacks:
+                line += f"  UART bytes/change {(last['tx_bytes'] - first['tx_bytes']) / callbacks:5.1f}"
+
+        if self.latencies:
+            line += f"  latency median {statistics.median(self.latencies):6.1f} ms  max {max(self.latencies):6.1f} ms"
+
+        print(line)
+        if final:
+            lost = len(self.pending_orders)
+            print(f"orders without service call: {lost}")
+            if self.record:
+                self.record.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=6053)
+    parser.add_argument("--password", default="")
+    parser.add_argument("--encryption-key", help="API encryption key (noise PSK)")
+    parser.add_argument("--rate", type=float, default=20.0, help="average state changes per second")
+    parser.add_argument("--burst", type=int, default=1, help="state changes sent back to back")
+    parser.add_argument("--duration", type=float, default=30.0)
+    parser.add_argument("--settle", type=float, default=2.0, help="seconds to wait for subscriptions and answers")
+    parser.add_argument("--order-interval", type=float, default=1.0, help="seconds between injected Mega orders")
+    parser.add_argument("--orders-per-round", type=int, default=1)
+    parser.add_argument(
+        "--light", action="append", default=[], metavar="ID:ENTITY", help="communication id of a connected light"
+    )
+    parser.add_argument("--record", help="JSON lines file receiving every service call")
+    parser.add_argument("--address", type=int, help="bus address of the tested controller (connected_bedroom_bus)")
+    asyncio.run(SoakTest(parser.parse_args()).run())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,590 @@
+#!/usr/bin/env python3
+"""Simulateur de l'Arduino Mega pour tester la liaison UART du composant `connected_bedroom` sans le matériel.
+
+Le simulateur implémente le protocole vu par `ConnectedBedroom::process_message_()` et par les méthodes `write_state`
+et `control` des périphériques : ordres, mises à jour de chaque type de périphérique (avec leur version `#VVV`),
+messages, synchronisation complète ou différentielle (`300`, `308EEE...` puis `301EEE...`, `303EEE`), acquittement
+des trames critiques (`*SS` -> `304SS`), trames de surveillance (`305SSS`), longues trames envoyées par morceaux
+(`7KKNN...`, avec des crédits `307CC`), trames regroupant plusieurs enregistrements (`8NN` puis `LL` et la trame de
+chacun) et musique.
+Avec `--address`, il se comporte comme un microcontrôleur d'un bus partagé (`connected_bedroom_bus`) : trames
+préfixées de `@NN`, émission seulement après avoir été interrogé (`@NN306`).
+
+Il s'attache à un pseudo-terminal Linux (par défaut, son chemin est affiché au démarrage) ou à un port série, limite
+son débit d'émission à celui de la liaison, peut générer des rafales de mises à jour de capteurs, des rafales de
+demandes de synchronisation, des redémarrages et des silences, et affiche chaque seconde le débit, l'occupation de la
+file d'émission et les anomalies observées (doublons, trames inconnues), pour mesurer le débit, la saturation et le
+rétablissement du composant à n'importe quel débit.
+
+Exemple :
+    tools/mega_simulator.py --device switch:1 --device alarm:2 --device television:3 --device rgb_strip:4 \\
+        --device analog_sensor:10 --device temperature:11 --storm 200:5:10 --resync-burst 20:20 --baudrate 115200
+"""
+
+import argparse
+import os
+import random
+import selectors
+import sys
+import termios
+import time
+import tty
+
+DEVICE_TYPES = (
+    "switch",
+    "alarm",
+    "television",
+    "rgb_strip",
+    "addressable_strip",
+    "binary_sensor",
+    "analog_sensor",
+    "temperature",
+    "multi_sensor",
+    "connected_light",
+)
+STORM_TYPES = ("binary_sensor", "analog_sensor", "temperature", "multi_sensor")
+BAUDRATES = {
+    9600: termios.B9600,
+    19200: termios.B19200,
+    38400: termios.B38400,
+    57600: termios.B57600,
+    115200: termios.B115200,
+    230400: termios.B230400,
+}
+
+
+def zeros(value, width):
+    return str(int(value)).zfill(width)[-width:]
+
+
+def parse_versions(body):
+    """Lit les versions des périphériques d'une demande de synchronisation différentielle (`IIVVV` pour chacun)."""
+    return {int(body[i : i + 2]): int(body[i + 2 : i + 5]) for i in range(0, len(body) - 4, 5)}
+
+
+class Device:
+    """Un périphérique simulé : son état et la version de celui-ci (incrémentée à chaque modification)."""
+
+    def __init__(self, device_type, communication_id):
+        self.type = device_type
+        self.id = communication_id
+        self.version = 0
+        self.state = {
+            "switch": {"on": 0},
+            "alarm": {"armed": 0, "ringing": 0, "base": 90, "angle": 45, "missiles": [1, 1, 1]},
+            "television": {"on": 0, "volume": 20, "muted": 0},
+            "rgb_strip": {"on": 0, "color": (255, 255, 255), "effect": 0, "parameters": {}},
+            "addressable_strip": {"pixels": {}, "images": 0},
+            "binary_sensor": {"value": 0},
+            "analog_sensor": {"value": 0},
+            "temperature": {"temperature": 2000, "humidity": 5000},
+            "multi_sensor": {"values": [2000, 5000, 101300]},
+            "connected_light": {},
+        }[device_type]
+
+    def touch(self):
+        self.version = (self.version + 1) % 1000
+
+    def header(self):
+        return "1" + zeros(self.id, 2)
+
+    def updates(self):
+        """Retourne les trames de mise à jour décrivant l'état complet du périphérique."""
+        s, h = self.state, self.header()
+        if self.type == "switch":
+            return [h + "01" + str(s["on"])]
+        if self.type == "alarm":
+            frames = [h + "030" if s["armed"] else h + "010"]
+            if s["ringing"]:
+                frames.append(h + "031")
+            frames.append(h + "032" + zeros(s["base"], 3))
+            frames.append(h + "033" + zeros(s["angle"], 3))
+            frames.append(h + "034" + "".join(str(m) for m in s["missiles"]))
+            return frames
+        if self.type == "television":
+            return [h + "01" + str(s["on"]), h + "040" + zeros(s["volume"], 2), h + ("041" if s["muted"] else "042")]
+        if self.type == "rgb_strip":
+            if s["effect"]:
+                return [h + "01" + str(s["on"]), h + "02" + str(s["effect"])]
+            return [h + "01" + str(s["on"]), h + "020" + "".join(zeros(c, 3) for c in s["color"])]
+        if self.type == "binary_sensor":
+            return [h + "07" + str(s["value"])]
+        if self.type == "analog_sensor":
+            return [h + "08" + zeros(s["value"], 4)]
+        if self.type == "temperature":
+            return [h + "09" + zeros(s["temperature"], 4) + zeros(s["humidity"], 4)]
+        if self.type == "multi_sensor":
+            values = "".join(("-" if v < 0 else "+") + zeros(abs(v), 5) for v in s["values"])
+            return [h + "10" + str(len(s["values"])) + values]
+        return []
+
+    def randomize(self):
+        """Modifie aléatoirement la valeur d'un capteur et retourne la trame de mise à jour correspondante."""
+        s = self.state
+        if self.type == "binary_sensor":
+            s["value"] ^= 1
+        elif self.type == "analog_sensor":
+            s["value"] = random.randint(0, 1023)
+        elif self.type == "temperature":
+            s["temperature"] = random.randint(1500, 3000)
+            s["humidity"] = random.randint(2000, 8000)
+        elif self.type == "multi_sensor":
+            s["values"] = [random.randint(-1000, 4000), random.randint(2000, 8000), random.randint(95000, 99999)]
+        self.touch()
+        return self.updates()[0]
+
+    def order(self, opcode, argument):
+        """Exécute un ordre (`0IIOO...`) et retourne les trames de mise à jour résultantes, `None` s'il est inconnu."""
+        s, h = self.state, self.header()
+        if self.type in ("switch", "television", "rgb_strip") and opcode == "00" and argument[:1] in ("0", "1"):
+            s["on"] = int(argument[0])
+            self.touch()
+            return [h + "01" + argument[0]]
+
+        if self.type == "alarm":
+            command = opcode + argument[:1]
+            if command == "001":
+                s["armed"], s["ringing"] = 1, 0
+                self.touch()
+                return [h + "030"]
+            if command == "000":
+                s["armed"], s["ringing"] = 0, 0
+                self.touch()
+                return [h + "010"]
+            if command == "020":
+                s["ringing"] = 0
+                self.touch()
+                return [h + "030"]
+            if command == "021":
+                s["armed"], s["ringing"] = 1, 1
+                self.touch()
+                return [h + "031"]
+            if command in ("022", "023") and len(argument) >= 4:
+                key = "base" if command == "022" else "angle"
+                s[key] = int(argument[1:4])
+                self.touch()
+                return [h + "03" + ("2" if key == "base" else "3") + zeros(s[key], 3)]
+            if command == "025" and len(argument) >= 7:
+                for key, value in (("base", int(argument[1:4])), ("angle", int(argument[4:7]))):
+                    if value != 999:
+                        s[key] = value
+                self.touch()
+                return [h + "035" + zeros(s["base"], 3) + zeros(s["angle"], 3)]
+            if command == "024":
+                if 1 in s["missiles"]:
+                    s["missiles"][s["missiles"].index(1)] = 0
+                self.touch()
+                return [h + "034" + "".join(str(m) for m in s["missiles"])]
+
+        if self.type == "television" and opcode == "03":
+            if argument[:1] in ("0", "1"):
+                s["volume"] = max(0, min(99, s["volume"] + (1 if argument[0] == "1" else -1)))
+                self.touch()
+                return [h + "040" + zeros(s["volume"], 2)]
+            if argument[:1] == "4" and len(argument) >= 3:
+                s["volume"] = min(99, int(argument[1:3]))
+                self.touch()
+                return [h + "040" + zeros(s["volume"], 2)]
+            if argument[:1] in ("2", "3"):
+                s["muted"] = 1 if argument[0] == "2" else 0
+                self.touch()
+                return [h + ("041" if s["muted"] else "042")]
+
+        if self.type == "rgb_strip" and opcode == "01":
+            if argument[:1] == "0" and len(argument) >= 10:
+                s["color"] = (int(argument[1:4]), int(argument[4:7]), int(argument[7:10]))
+                s["effect"], s["on"] = 0, 1
+                self.touch()
+                return [h + "020" + argument[1:10]]
+            if argument[:1] == "5" and len(argument) >= 14:
+                s["parameters"][int(argument[1])] = tuple(int(argument[i : i + 3]) for i in range(2, 14, 3))
+                return []
+            if argument[:1] in ("1", "2", "3"):
+                s["effect"], s["on"] = int(argument[0]), 1
+                self.touch()
+                return [h + "02" + argument[0]]
+
+        if self.type == "addressable_strip" and opcode == "05" and argument[:1] in ("0", "1"):
+            records = argument[1:]
+            for i in range(0, len(records) - 11, 12):
+                start, count, color = int(records[i : i + 3]), int(records[i + 3 : i + 6]), records[i + 6 : i + 12]
+                for pixel in range(start, start + count):
+                    s["pixels"][pixel] = color
+            if argument[0] == "1":
+                s["images"] += 1
+            return []
+
+        return None
+
+
+class Link:
+    """Extrémité série du simulateur, avec une file d'émission limitée au débit de la liaison (10 bits par octet)."""
+
+    def __init__(self, port, baudrate):
+        if port:
+            self.fd = os.open(port, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+            self.name = port
+        else:
+            self.fd, slave = os.openpty()
+            self.name = os.ttyname(slave)
+            self.slave = slave
+        tty.setraw(self.fd)
+        attributes = termios.tcgetattr(self.fd)
+        speed = BAUDRATES.get(baudrate, termios.B9600)
+        attributes[4] = attributes[5] = speed
+        termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+        os.set_blocking(self.fd, False)
+
+        self.bytes_per_second = baudrate / 10
+        self.queue = bytearray()
+        self.budget = 0.0
+        self.last_refill = time.monotonic()
+
+    def send(self, frame):
+        self.queue += frame.encode("ascii") + b"\n"
+
+    def flush(self):
+        now = time.monotonic()
+        self.budget = min(self.budget + (now - self.last_refill) * self.bytes_per_second, self.bytes_per_second / 100)
+        self.last_refill = now
+        count = min(int(self.budget), len(self.queue))
+        if count <= 0:
+            return 0
+        try:
+            written = os.write(self.fd, self.queue[:count])
+        except (BlockingIOError, OSError):
+            return 0
+        del self.queue[:written]
+        self.budget -= written
+        return written
+
+    def receive(self):
+        try:
+            return os.read(self.fd, 4096)
+        except (BlockingIOError, OSError):
+            return b""
+
+
+class Statistics:
+    def __init__(self):
+        self.counters = {}
+
+    def add(self, name, value=1):
+        self.counters[name] = self.counters.get(name, 0) + value
+
+    def take(self):
+        counters, self.counters = self.counters, {}
+        return counters
+
+
+class Simulator:
+    def __init__(self, args):
+        self.args = args
+        self.devices = {}
+        for device in args.device:
+            device_type, communication_id = device.split(":")
+            if device_type not in DEVICE_TYPES:
+                sys.exit(f"unknown device type '{device_type}', expected one of {', '.join(DEVICE_TYPES)}")
+            self.devices[int(communication_id)] = Device(device_type, int(communication_id))
+
+        self.epoch = args.epoch if args.epoch is not None else random.randint(0, 999)
+        self.link = Link(args.port, args.baudrate)
+        self.statistics = Statistics()
+        self.totals = Statistics()
+        self.buffer = bytearray()
+        self.received_sequences = []
+        self.chunks = []
+        self.pending_versions = {}
+        self.outbox = []
+        self.start = time.monotonic()
+        self.events = self.schedule()
+        self.storm = None
+        self.storm_sent_at = 0.0
+        self.silent_until = 0.0
+
+    def schedule(self):
+        """Prépare la liste des évènements du scénario, triée par instant (en secondes depuis le démarrage)."""
+        events = []
+        for storm in self.args.storm:
+            rate, start, duration = (float(value) for value in storm.split(":"))
+            events.append((start, "storm", (rate, start + duration)))
+        for burst in self.args.resync_burst:
+            count, at = burst.split(":")
+            events.append((float(at), "resync", int(count)))
+        for at in self.args.reboot:
+            events.append((float(at), "reboot", None))
+        for silence in self.args.silence:
+            start, duration = (float(value) for value in silence.split(":"))
+            events.append((start, "silence", start + duration))
+        for at in self.args.message:
+            events.append((float(at), "message", None))
+        for music in self.args.music:
+            index, at = music.split(":")
+            events.append((float(at), "music", int(index)))
+        return sorted(events, key=lambda event: event[0])
+
+    def send(self, frame, versioned=False, device=None):
+        if self.silent():
+            return
+        if versioned and device is not None and self.args.versions:
+            frame += "#" + zeros(device.version, 3)
+        if self.args.address is not None:
+            self.outbox.append(frame)
+        else:
+            self.link.send(frame)
+        self.statistics.add("tx_frames")
+        self.log(">", frame)
+
+    def log(self, direction, frame):
+        if self.args.verbose:
+            print(f"{time.monotonic() - self.start:9.3f} {direction} {frame}")
+
+    def silent(self):
+        return self.silent_until > time.monotonic() - self.start
+
+    def send_device(self, device, frames):
+        for frame in frames:
+            self.send(frame, versioned=True, device=device)
+
+    def synchronize(self, versions=None):
+        """Envoie l'époque puis l'état des périphériques (uniquement ceux dont la version a changé si `versions`)."""
+        self.send("303" + zeros(self.epoch, 3))
+        records = []
+        for device in self.devices.values():
+            if versions is not None and versions.get(device.id) == device.version:
+                continue
+            if not self.args.batch_sync:
+                self.send_device(device, device.updates())
+                continue
+            for frame in device.updates():
+                records.append(frame + ("#" + zeros(device.version, 3) if self.args.versions else ""))
+        if records:
+            self.send_batches(records)
+        self.statistics.add("synchronizations")
+
+    def send_batches(self, records):
+        """Envoie des trames regroupées (`8NN` puis `LL` et la trame de chaque enregistrement)."""
+        batch = []
+        for record in records + [None]:
+            body = "".join(zeros(len(frame), 2) + frame for frame in batch)
+            if batch and (record is None or len(batch) == 99 or 3 + len(body) + 2 + len(record) > self.args.batch_size):
+                self.send("8" + zeros(len(batch), 2) + body)
+                self.statistics.add("batches")
+                batch = []
+            if record is not None:
+                batch.append(record)
+
+    def receive_line(self, line):
+        """Traite une ligne reçue ; sur un bus, seules les lignes adressées à ce microcontrôleur sont traitées."""
+        if self.args.address is None:
+            self.handle(line)
+            return
+        address = "@" + zeros(self.args.address, 2)
+        if not line.startswith(address):
+            return
+        frame = line[len(address) :]
+        if frame != "306":
+            self.handle(frame)
+            return
+
+        # Interrogation : émission des trames en attente, puis la parole est rendue.
+        self.statistics.add("polls")
+        for pending in self.outbox:
+            self.link.send(address + pending)
+        self.outbox = []
+        self.link.send(address + "306")
+
+    def handle(self, frame):
+        self.statistics.add("rx_frames")
+        self.log("<", frame)
+        if self.silent() or not frame:
+            return
+
+        # Trame critique : acquittement (y compris des doublons, qui ne sont pas exécutés une seconde fois).
+        if "*" in frame:
+            frame, sequence = frame.rsplit("*", 1)
+            if random.random() >= self.args.drop_ack:
+                self.send("304" + zeros(sequence, 2))
+            if sequence in self.received_sequences:
+                self.statistics.add("duplicates")
+                return
+            self.received_sequences = (self.received_sequences + [sequence])[-8:]
+
+        # Morceau d'une longue trame : la trame est traitée une fois complète, puis un crédit est accordé.
+        if frame[0] == "7" and len(frame) >= 5:
+            index, count = int(frame[1:3]), int(frame[3:5])
+            if index == 0:
+                self.chunks = []
+            if index != len(self.chunks):
+                self.statistics.add("lost_chunks")
+                self.chunks = []
+            else:
+                self.chunks.append(frame[5:])
+            self.statistics.add("chunks")
+            self.send("307" + zeros(self.args.chunk_credit, 2))
+            if self.chunks and len(self.chunks) == count:
+                frame, self.chunks = "".join(self.chunks), []
+                self.handle(frame)
+            return
+
+        # Trame regroupée : chaque enregistrement est traité comme une trame reçue seule.
+        if frame[0] == "8" and len(frame) >= 3:
+            count, position = int(frame[1:3]), 3
+            for _ in range(count):
+                length = int(frame[position : position + 2] or 0)
+                record = frame[position + 2 : position + 2 + length]
+                if length == 0 or len(record) != length:
+                    self.statistics.add("truncated_batches")
+                    break
+                self.handle(record)
+                position += 2 + length
+            self.statistics.add("batches")
+            return
+
+        kind = frame[0]
+        if kind == "0" and len(frame) >= 5:
+            device = self.devices.get(int(frame[1:3]))
+            frames = device.order(frame[3:5], frame[5:]) if device is not None else None
+            if frames is None:
+                self.statistics.add("unknown_frames")
+                return
+            self.statistics.add("orders")
+            self.send_device(device, frames)
+
+        elif kind == "1":
+            self.statistics.add("connected_device_updates")
+
+        elif kind in ("2", "6"):
+            self.statistics.add("messages")
+
+        elif frame.startswith("300"):
+            self.synchronize()
+
+        elif frame.startswith("308") and len(frame) >= 6:
+            self.pending_versions.update(parse_versions(frame[6:]))
+
+        elif frame.startswith("301") and len(frame) >= 6:
+            epoch, versions = int(frame[3:6]), {**self.pending_versions, **parse_versions(frame[6:])}
+            self.pending_versions = {}
+            self.synchronize(versions if epoch == self.epoch else None)
+
+        elif frame.startswith("305"):
+            self.statistics.add("pings")
+            self.send(frame)
+
+        else:
+            self.statistics.add("unknown_frames")
+
+    def run_event(self, name, value):
+        if name == "storm":
+            self.storm = value
+            self.storm_sent_at = time.monotonic() - self.start
+        elif name == "resync":
+            for _ in range(value):
+                self.send("301")
+        elif name == "reboot":
+            self.epoch = (self.epoch + 1) % 1000
+            for device in self.devices.values():
+                device.version = 0
+            self.send("303" + zeros(self.epoch, 3))
+        elif name == "silence":
+            self.silent_until = value
+        elif name == "message":
+            self.send("2Simulated message")
+        elif name == "music":
+            self.send("5" + zeros(value, 3))
+        print(f"{time.monotonic() - self.start:9.3f} event: {name}")
+
+    def run_storm(self, elapsed):
+        if self.storm is None:
+            return
+        rate, end = self.storm
+        if elapsed >= end:
+            self.storm = None
+            return
+        sensors = [device for device in self.devices.values() if device.type in STORM_TYPES]
+        if not sensors:
+            return
+        due = int(elapsed * rate) - int(self.storm_sent_at * rate)
+        self.storm_sent_at = elapsed
+        for _ in range(max(due, 0)):
+            device = random.choice(sensors)
+            self.send(device.randomize(), versioned=True, device=device)
+
+    def report(self, elapsed, counters):
+        for name, value in counters.items():
+            self.totals.add(name, value)
+        print(
+            f"{elapsed:9.3f} rx {counters.get('rx_frames', 0):5}/s ({counters.get('rx_bytes', 0):6} B)"
+            f"  tx {counters.get('tx_frames', 0):5}/s ({counters.get('tx_bytes', 0):6} B)"
+            f"  backlog {len(self.link.queue):6} B"
+            f"  pings {counters.get('pings', 0):3}  dup {counters.get('duplicates', 0):3}"
+            f"  unknown {counters.get('unknown_frames', 0):3}"
+        )
+
+    def run(self):
+        print(f"Simulated Arduino Mega on {self.link.name} (epoch {self.epoch}, {len(self.devices)} devices).")
+        selector = selectors.DefaultSelector()
+        selector.register(self.link.fd, selectors.EVENT_READ)
+        next_report = 1.0
+        if self.args.announce:
+            self.send("303" + zeros(self.epoch, 3))
+
+        try:
+            while self.args.duration <= 0 or time.monotonic() - self.start < self.args.duration:
+                elapsed = time.monotonic() - self.start
+                while self.events and self.events[0][0] <= elapsed:
+                    _, name, value = self.events.pop(0)
+                    self.run_event(name, value)
+                self.run_storm(elapsed)
+
+                for _ in selector.select(timeout=0.001):
+                    data = self.link.receive()
+                    self.statistics.add("rx_bytes", len(data))
+                    for byte in data:
+                        if byte == ord("\n"):
+                            self.receive_line(self.buffer.decode("ascii", errors="replace").replace("\r", ""))
+                            self.buffer.clear()
+                        else:
+                            self.buffer.append(byte)
+
+                self.statistics.add("tx_bytes", self.link.flush())
+
+                if elapsed >= next_report:
+                    self.report(elapsed, self.statistics.take())
+                    next_report += 1.0
+        except KeyboardInterrupt:
+            pass
+
+        self.report(time.monotonic() - self.start, self.statistics.take())
+        print("totals: " + ", ".join(f"{name}={value}" for name, value in sorted(self.totals.counters.items())))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", help="serial port to use instead of a new pseudo-terminal")
+    parser.add_argument("--baudrate", type=int, default=9600, choices=sorted(BAUDRATES))
+    parser.add_argument(
+        "--device", action="append", default=[], metavar="TYPE:ID", help=f"device ({', '.join(DEVICE_TYPES)})"
+    )
+    parser.add_argument("--address", type=int, help="node address on a shared bus (frames prefixed with '@NN')")
+    parser.add_argument("--epoch", type=int, help="initial epoch (random by default)")
+    parser.add_argument("--no-versions", dest="versions", action="store_false", help="omit the '#VVV' suffixes")
+    parser.add_argument("--announce", action="store_true", help="announce the epoch at startup")
+    parser.add_argument("--storm", action="append", default=[], metavar="RATE:START:DURATION")
+    parser.add_argument("--resync-burst", action="append", default=[], metavar="COUNT:AT")
+    parser.add_argument("--reboot", action="append", default=[], metavar="AT")
+    parser.add_argument("--silence", action="append", default=[], metavar="START:DURATION")
+    parser.add_argument("--message", action="append", default=[], metavar="AT")
+    parser.add_argument("--music", action="append", default=[], metavar="PRESET:AT", help="start a music preset")
+    parser.add_argument("--batch-sync", action="store_true", help="send synchronizations in multi-record frames")
+    parser.add_argument("--batch-size", type=int, default=120, help="maximum length of a multi-record frame")
+    parser.add_argument("--chunk-credit", type=int, default=4, help="chunks granted after each received chunk")
+    parser.add_argument("--drop-ack", type=float, default=0.0, help="probability of dropping an acknowledgement")
+    parser.add_argument("--duration", type=float, default=0.0, help="stop after this many seconds")
+    parser.add_argument("--verbose", action="store_true", help="print every frame")
+    Simulator(parser.parse_args()).run()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Outil de rejeu du trafic UART enregistré par le composant `connected_bedroom`.
+
+Le composant (option `traffic_recorder`) affiche le trafic via le service `dump_traffic`, sous forme de lignes
+`traffic <hex>` dans les journaux. Cet outil :
+
+- `extract` : reconstitue le fichier binaire à partir d'un journal (`esphome logs ... > log.txt`) ;
+- `show` : affiche les trames enregistrées, avec leur instant et leur sens ;
+- `replay` : renvoie les octets reçus de l'Arduino Mega (sens RX) vers un port série ou un pseudo-terminal, en
+  respectant les intervalles d'origine, afin de reproduire une séquence sur un ESP8266 ou un banc de test.
+
+Seule la bibliothèque standard est nécessaire (plus `pyserial` pour rejouer vers un vrai port série à un débit donné).
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import time
+
+MAGIC = b"CBR1"
+DIRECTIONS = {0: "RX", 1: "TX"}
+LINE_PATTERN = re.compile(r"traffic ((?:[0-9a-fA-F]{2})+)\s*$")
+
+
+def extract(log_path, output_path):
+    """Reconstitue le flux binaire à partir des lignes `traffic <hex>` du dernier dump du journal."""
+    data = bytearray()
+    with open(log_path, "r", encoding="utf-8", errors="replace") as log:
+        for line in log:
+            if "traffic begin" in line:
+                data = bytearray()
+                continue
+            match = LINE_PATTERN.search(line)
+            if match:
+                data += bytes.fromhex(match.group(1))
+
+    if not data.startswith(MAGIC):
+        sys.exit("no traffic dump found in log")
+
+    with open(output_path, "wb") as output:
+        output.write(data)
+    print(f"{len(parse(bytes(data)))} records written to {output_path}")
+
+
+def parse(data):
+    """Retourne la liste des enregistrements `(instant, sens, octets)`."""
+    if not data.startswith(MAGIC):
+        raise ValueError("invalid traffic file header")
+
+    records = []
+    position = len(MAGIC)
+    while position + 6 <= len(data):
+        direction, timestamp, length = struct.unpack_from("<BIB", data, position)
+        position += 6
+        records.append((timestamp, direction, data[position : position + length]))
+        position += length
+    return records
+
+
+def load(path):
+    with open(path, "rb") as file:
+        return parse(file.read())
+
+
+def frames(records):
+    """Regroupe les enregistrements en trames terminées par un retour à la ligne, pour chaque sens."""
+    pending = {}
+    for timestamp, direction, payload in records:
+        buffer, start = pending.get(direction, (bytearray(), timestamp))
+        if not buffer:
+            start = timestamp
+        for byte in payload:
+            if byte == ord("\n"):
+                yield start, direction, buffer.decode("ascii", errors="replace").rstrip("\r")
+                buffer, start = bytearray(), timestamp
+            else:
+                buffer.append(byte)
+        pending[direction] = (buffer, start)
+
+
+def show(path):
+    records = load(path)
+    if not records:
+        return
+    origin = records[0][0]
+    for timestamp, direction, frame in frames(records):
+        print(f"{timestamp - origin:>8} ms  {DIRECTIONS.get(direction, '??')}  {frame}")
+
+
+def open_output(path, baudrate):
+    try:
+        import serial  # pylint: disable=import-outside-toplevel
+
+        port = serial.Serial(path, baudrate)
+        return port.write, port.close
+    except ImportError:
+        fd = os.open(path, os.O_WRONLY | os.O_NOCTTY)
+        return lambda data: os.write(fd, data), lambda: os.close(fd)
+
+
+def replay(path, output_path, baudrate, speed):
+    records = [record for record in load(path) if record[1] == 0]
+    if not records:
+        sys.exit("no received bytes to replay")
+
+    write, close = open_output(output_path, baudrate)
+    origin = records[0][0]
+    start = time.monotonic()
+    try:
+        for timestamp, _, payload in records:
+            delay = (timestamp - origin) / 1000 / speed - (time.monotonic() - start)
+            if delay > 0:
+                time.sleep(delay)
+            write(bytes(payload))
+    finally:
+        close()
+    print(f"{len(records)} records replayed to {output_path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    extract_parser = subparsers.add_parser("extract", help="extract a traffic dump from an ESPHome log")
+    extract_parser.add_argument("log")
+    extract_parser.add_argument("output")
+
+    show_parser = subparsers.add_parser("show", help="print the recorded frames")
+    show_parser.add_argument("file")
+
+    replay_parser = subparsers.add_parser("replay", help="replay the Mega-side bytes to a serial port or pty")
+    replay_parser.add_argument("file")
+    replay_parser.add_argument("port")
+    replay_parser.add_argument("--baudrate", type=int, default=9600)
+    replay_parser.add_argument("--speed", type=float, default=1.0, help="time scale factor")
+
+    args = parser.parse_args()
+    if args.command == "extract":
+        extract(args.log, args.output)
+    elif args.command == "show":
+        show(args.file)
+    else:
+        replay(args.file, args.port, args.baudrate, args.speed)
+
+
+if __name__ == "__main__":
+    main()